@@ -0,0 +1,123 @@
+/*
+ * Instruction dispatch microbenchmark
+ *
+ * Runs a CALC only program the way the CPUs do: one run() per time
+ * slot, and run_batch() over CPU_BATCH instructions at a time. The
+ * baseline is the interpreter run() used to be, copying a struct inst_t
+ * by value and switching on its opcode. Built by "make dbench" against
+ * the same objects as the os binary. The program size is the first
+ * argument, large programs show the cost of the wider inst_t in cache.
+ */
+
+#include "cpu.h"
+#include "libmem.h"
+#include "os-cfg.h"
+#include "syscall.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define PROG_SIZE 4096
+#define TOTAL_INSNS (8L << 20)
+
+int calc(struct pcb_t *proc);
+
+/* run() before the loader decoded programs */
+static int switch_run(struct pcb_t *proc, const struct inst_t *text)
+{
+	if (proc->pc >= proc->code->size)
+		return 1;
+
+	struct inst_t ins = text[proc->pc];
+	proc->pc++;
+	int stat = 1;
+	switch (ins.opcode) {
+	case CALC:
+		stat = calc(proc);
+		break;
+	case ALLOC:
+		stat = liballoc(proc, ins.arg_0, ins.arg_1);
+		break;
+	case FREE:
+		stat = libfree(proc, ins.arg_0);
+		break;
+	case READ:
+		proc->nr_io++;
+		stat = libread(proc, ins.arg_0, ins.arg_1, (uint32_t*) &ins.arg_2);
+		break;
+	case WRITE:
+		proc->nr_io++;
+		stat = libwrite(proc, ins.arg_0, ins.arg_1, ins.arg_2);
+		break;
+	case SYSCALL:
+		proc->nr_io++;
+		stat = libsyscall(proc, ins.arg_0, ins.arg_1, ins.arg_2, ins.arg_3);
+		break;
+	default:
+		stat = 1;
+	}
+	return stat;
+}
+
+static double now(void) {
+	struct timespec t;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+static long size, rounds;
+
+static void report(const char * name, double sec) {
+	double ops = (double)size * rounds;
+
+	printf("%-28s %10.2f %10.2f\n", name, ops / sec / 1e6, sec * 1e9 / ops);
+}
+
+int main(int argc, char * argv[]) {
+	struct inst_t * text;
+	struct code_seg_t code;
+	struct pcb_t proc = { 0 };
+	double t0;
+	long i;
+	int r;
+
+	size = (argc > 1) ? atol(argv[1]) : PROG_SIZE;
+	rounds = TOTAL_INSNS / size > 0 ? TOTAL_INSNS / size : 1;
+
+	/* calloc leaves every instruction a CALC, both forms */
+	text = calloc(size, sizeof(struct inst_t));
+	code.text = calloc(size, sizeof(struct op_t));
+	code.size = size;
+	for (i = 0; i < size; i++)
+		code.text[i].b = size - i;	/* the loader's CALC run */
+	code.wide = NULL;
+	code.nr_wide = 0;
+	proc.code = &code;
+
+	printf("%ld instructions, %zu bytes each as inst_t, %zu as op_t\n",
+		size, sizeof(struct inst_t), sizeof(struct op_t));
+	printf("%-28s %10s %10s\n", "dispatch", "Minsn/s", "ns/insn");
+
+	t0 = now();
+	for (r = 0; r < rounds; r++)
+		for (proc.pc = 0; proc.pc < size; )
+			switch_run(&proc, text);
+	report("switch, inst_t by value", now() - t0);
+
+	t0 = now();
+	for (r = 0; r < rounds; r++)
+		for (proc.pc = 0; proc.pc < size; )
+			run(&proc);
+	report("run(), computed goto", now() - t0);
+
+	t0 = now();
+	for (r = 0; r < rounds; r++)
+		for (proc.pc = 0; proc.pc < size; )
+			run_batch(&proc, CPU_BATCH);
+	report("run_batch(), CPU_BATCH", now() - t0);
+
+	free(code.text);
+	free(text);
+	return 0;
+}
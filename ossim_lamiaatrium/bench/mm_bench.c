@@ -0,0 +1,126 @@
+/*
+ * Memory lock contention microbenchmark
+ *
+ * One thread per process, each writing and reading back a region of its
+ * own mm through __write() and __read(), the path of the WRITE and READ
+ * instructions without the log. The baseline wraps every call in one
+ * mutex shared by all threads, the way libmem serialized every process
+ * on mmvm_lock before each mm had its own lock. Built by "make mbench"
+ * against the same objects as the os binary. The most threads is the
+ * first argument.
+ */
+
+#include "common.h"
+#include "libmem.h"
+#include "mm.h"
+#include "queue.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define MAX_THREADS 8
+#define REGION_SIZE 1024
+#define OPS_PER_THREAD (1L << 20)
+
+int __alloc(struct pcb_t *caller, int vmaid, int rgid, addr_t size, addr_t *alloc_addr);
+int __read(struct pcb_t *caller, int vmaid, int rgid, addr_t offset, BYTE *data);
+int __write(struct pcb_t *caller, int vmaid, int rgid, addr_t offset, BYTE value);
+
+static pthread_mutex_t global_lock = PTHREAD_MUTEX_INITIALIZER;
+static int use_global;
+
+static double now(void) {
+	struct timespec t;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+static void * worker(void * arg) {
+	struct pcb_t * proc = arg;
+	addr_t off;
+	BYTE data;
+	long i;
+
+	for (i = 0; i < OPS_PER_THREAD; i++) {
+		off = i % REGION_SIZE;
+		if (use_global)
+			pthread_mutex_lock(&global_lock);
+		__write(proc, 0, 0, off, (BYTE)i);
+		if (use_global) {
+			pthread_mutex_unlock(&global_lock);
+			pthread_mutex_lock(&global_lock);
+		}
+		__read(proc, 0, 0, off, &data);
+		if (use_global)
+			pthread_mutex_unlock(&global_lock);
+	}
+	return NULL;
+}
+
+static void report(const char * name, int nr, double sec) {
+	double ops = 2.0 * OPS_PER_THREAD * nr;
+
+	printf("%-28s %8d %10.2f %10.2f\n", name, nr, ops / sec / 1e6,
+		sec * 1e9 / ops);
+}
+
+int main(int argc, char * argv[]) {
+	static struct pcb_t procs[MAX_THREADS];
+	struct memphy_struct mram, mswp[PAGING_MAX_MMSWP];
+	struct queue_t running[MAX_THREADS] = { { 0 } };
+	pthread_mutex_t running_lock[MAX_THREADS];
+	pthread_t threads[MAX_THREADS];
+	struct krnl_t krnl;
+	addr_t addr;
+	double t0;
+	int max, nr, i;
+
+	max = (argc > 1) ? atoi(argv[1]) : MAX_THREADS;
+	if (max < 1 || max > MAX_THREADS)
+		max = MAX_THREADS;
+
+	init_memphy(&mram, 1 << 20, 1);
+	for (i = 0; i < PAGING_MAX_MMSWP; i++)
+		init_memphy(&mswp[i], 1 << 20, 1);
+	krnl.running_list = running;
+	krnl.running_lock = running_lock;
+	krnl.nr_cpus = max;
+	krnl.mm = NULL;
+	krnl.mram = &mram;
+	krnl.mswp = (struct memphy_struct **)&mswp;
+	krnl.active_mswp = &mswp[0];
+	krnl.active_mswp_id = 0;
+
+	/* sys_memmap finds the caller on the running lists */
+	for (i = 0; i < max; i++) {
+		pthread_mutex_init(&running_lock[i], NULL);
+		procs[i].pid = i + 1;
+		procs[i].krnl = &krnl;
+		procs[i].mram = krnl.mram;
+		procs[i].mswp = krnl.mswp;
+		procs[i].active_mswp = krnl.active_mswp;
+		procs[i].mm = malloc(sizeof(struct mm_struct));
+		init_mm(procs[i].mm, &procs[i]);
+		enqueue(&running[i], &procs[i]);
+		if (__alloc(&procs[i], 0, 0, REGION_SIZE, &addr) != 0) {
+			printf("mm_bench: alloc failed\n");
+			return 1;
+		}
+	}
+
+	printf("%-28s %8s %10s %10s\n", "lock", "threads", "Mops/s", "ns/op");
+	for (use_global = 1; use_global >= 0; use_global--) {
+		for (nr = 1; nr <= max; nr *= 2) {
+			t0 = now();
+			for (i = 0; i < nr; i++)
+				pthread_create(&threads[i], NULL, worker, &procs[i]);
+			for (i = 0; i < nr; i++)
+				pthread_join(threads[i], NULL);
+			report(use_global ? "global, as mmvm_lock" : "per mm",
+				nr, now() - t0);
+		}
+	}
+	return 0;
+}
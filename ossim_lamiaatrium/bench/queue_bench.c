@@ -0,0 +1,83 @@
+/*
+ * Ready queue microbenchmark
+ *
+ * Every thread hands PCBs through one shared queue: enqueue one,
+ * dequeue one, like the loader and the CPUs do on the ready queues.
+ * Built twice by "make qbench": once with queue_t guarded by a mutex
+ * the way the scheduler uses it, once with -DQUEUE_LOCKFREE on the
+ * lfqueue_t inbox ring.
+ */
+
+#include "queue.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+extern int sched_yield(void);	/* <sched.h> is shadowed by include/ */
+
+#define OPS_PER_THREAD 200000
+
+#ifdef QUEUE_LOCKFREE
+static struct lfqueue_t q;
+#else
+static struct queue_t q;
+static pthread_mutex_t q_lock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+static void * worker(void * args) {
+	struct pcb_t * proc = (struct pcb_t *)args;
+	long i;
+
+	for (i = 0; i < OPS_PER_THREAD; i++) {
+#ifdef QUEUE_LOCKFREE
+		while (lfq_enqueue(&q, proc) < 0)
+			sched_yield();
+		while ((proc = lfq_dequeue(&q)) == NULL)
+			sched_yield();
+#else
+		pthread_mutex_lock(&q_lock);
+		enqueue(&q, proc);
+		pthread_mutex_unlock(&q_lock);
+		do {
+			pthread_mutex_lock(&q_lock);
+			proc = dequeue(&q);
+			pthread_mutex_unlock(&q_lock);
+			if (proc == NULL)
+				sched_yield();
+		} while (proc == NULL);
+#endif
+	}
+	return NULL;
+}
+
+int main(int argc, char * argv[]) {
+	int max_threads = (argc > 1) ? atoi(argv[1]) : 8;
+	struct pcb_t * procs = calloc(max_threads, sizeof(struct pcb_t));
+	pthread_t * tid = malloc(sizeof(pthread_t) * max_threads);
+	int nthreads, i;
+
+#ifdef QUEUE_LOCKFREE
+	printf("queue: lock-free MPMC ring\n");
+#else
+	printf("queue: ring + pthread mutex\n");
+#endif
+	printf("%8s %12s %10s\n", "threads", "Mops/s", "ns/op");
+	for (nthreads = 1; nthreads <= max_threads; nthreads *= 2) {
+		struct timespec t0, t1;
+
+		clock_gettime(CLOCK_MONOTONIC, &t0);
+		for (i = 0; i < nthreads; i++)
+			pthread_create(&tid[i], NULL, worker, &procs[i]);
+		for (i = 0; i < nthreads; i++)
+			pthread_join(tid[i], NULL);
+		clock_gettime(CLOCK_MONOTONIC, &t1);
+
+		double sec = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+		double ops = 2.0 * OPS_PER_THREAD * nthreads;
+		printf("%8d %12.2f %10.1f\n", nthreads, ops / sec / 1e6, sec * 1e9 / ops);
+	}
+	free(procs);
+	free(tid);
+	return 0;
+}
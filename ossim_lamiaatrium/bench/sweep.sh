@@ -0,0 +1,66 @@
+#!/bin/sh
+#
+# Scaling sweep, run by "make bench" from the top of the tree: generates
+# workloads with tools/wlgen over CPU count, process count and RAM/swap
+# size, runs each on $OS and records the wall time, the time slots
+# simulated per second and the page faults per second. The table goes
+# to stdout and to bench/sweep.csv.
+#
+# "make bench" sets OS to bench/os_quiet, built with -DNO_IODUMP. Run
+# against the default ./os instead, the times mostly measure how fast
+# the page tables are dumped to the log.
+#
+# Override the axes through the environment, e.g.
+#	CPUS="1 4" PROCS=64 RAMS=65536 SWAPS=16777216 sh bench/sweep.sh
+# OS_OPTS is passed to os (e.g. "-e pool -s cfs").
+
+OS=${OS:-./os}
+CPUS=${CPUS:-"1 2 4 8"}
+PROCS=${PROCS:-"16 64 256"}
+RAMS=${RAMS:-"32768 1048576"}
+SWAPS=${SWAPS:-"16777216"}
+INSNS=${INSNS:-2000}
+WLGEN_OPTS=${WLGEN_OPTS:-""}
+OS_OPTS=${OS_OPTS:-""}
+CSV=bench/sweep.csv
+LOG=bench/sweep.log
+
+now() {
+	date +%s.%N
+}
+
+echo "cpus,procs,ram,swap,wall_s,slots,slots_per_s,faults,faults_per_s" > $CSV
+printf "%5s %6s %9s %9s %8s %8s %10s %8s %10s\n" \
+	cpus procs ram swap wall slots slots/s faults faults/s
+for cpus in $CPUS; do
+for procs in $PROCS; do
+for ram in $RAMS; do
+for swap in $SWAPS; do
+	name=sweep_c${cpus}_p${procs}_r${ram}_s${swap}
+	./tools/wlgen -c $cpus -p $procs -n $INSNS -R $ram -S $swap \
+		$WLGEN_OPTS $name || exit 1
+	t0=$(now)
+	$OS $OS_OPTS gen/$name > $LOG 2>&1 || {
+		echo "os failed on gen/$name, see $LOG"
+		exit 1
+	}
+	t1=$(now)
+	slots=$(grep -c "^Time slot" $LOG)
+	faults=$(sed -n 's/.*Page Fault Count *: *\([0-9]*\).*/\1/p' $LOG)
+	awk -v c=$cpus -v p=$procs -v r=$ram -v s=$swap -v t0=$t0 -v t1=$t1 \
+	    -v n=$slots -v f=${faults:-0} -v csv=$CSV 'BEGIN {
+		w = t1 - t0
+		if (w <= 0)
+			w = 1e-9
+		printf "%5d %6d %9d %9d %8.3f %8d %10.0f %8d %10.0f\n",
+			c, p, r, s, w, n, n / w, f, f / w
+		printf "%d,%d,%d,%d,%.3f,%d,%.0f,%d,%.0f\n",
+			c, p, r, s, w, n, n / w, f, f / w >> csv
+	}'
+	rm -rf input/gen/$name input/proc/gen/$name
+done
+done
+done
+done
+rm -f $LOG
+rmdir input/gen input/proc/gen 2>/dev/null
@@ -14,6 +14,9 @@
 #include "os-mm.h"
 #endif
 
+#include "rbtree.h"
+#include "wheel.h"
+
 #define ADDRESS_SIZE 20
 #define OFFSET_LEN 10
 #define FIRST_LV_LEN 5
@@ -57,7 +60,7 @@ enum ins_opcode_t
 	SYSCALL,
 };
 
-/* instructions executed by the CPU */
+/* An instruction as written in the program file */
 struct inst_t
 {
 	enum ins_opcode_t opcode;
@@ -67,10 +70,41 @@ struct inst_t
 	arg_t arg_3;
 };
 
+/*
+ * An instruction as the loader decodes it for the CPU, 16 bytes under
+ * MM64. [handler] picks the entry of run()'s dispatch table. The narrow
+ * operands (registers, the byte to write, the syscall number) sit in
+ * [a] and [c], the wide one in [b]:
+ *
+ *	CALC	b = CALC instructions in the run from this one on
+ *	ALLOC	a = register, b = size
+ *	FREE	a = register
+ *	READ	a = source register, b = offset, c = destination register
+ *	WRITE	a = data, b = offset, c = destination register
+ *	SYSCALL	a = number, b, c = first two arguments, the third is 0
+ *
+ * A syscall whose second argument does not fit in [c], or whose third
+ * is not 0, is a SYSCALL_WIDE: its three arguments are in the code
+ * segment's [wide] table from index b on.
+ */
+#define SYSCALL_WIDE (SYSCALL + 1)
+
+struct op_t
+{
+	uint16_t handler;
+	uint16_t c;
+	uint32_t a;
+	arg_t b;
+};
+
 struct code_seg_t
 {
-	struct inst_t *text;
+	struct op_t *text;
 	uint32_t size;
+	arg_t *wide;		// Operands too large for an op_t
+	uint32_t nr_wide;
+	void *image;		// Mapping of a binary image, NULL if parsed
+	size_t image_size;
 };
 
 struct trans_table_t
@@ -105,11 +139,30 @@ struct pcb_t
 	struct code_seg_t *code; // Code segment
 	addr_t regs[10];	 // Registers, store address of allocated regions
 	uint32_t pc;		 // Program pointer, point to the next instruction
-#ifdef MLQ_SCHED
+	int cpu;		 // CPU whose run queue holds the process
+	unsigned long qpos;	 // Slot in the queue holding it, for O(1) purge
 	// Priority on execution (if supported), on-fly aka. changeable
 	// and this vale overwrites the default priority when it existed
 	uint32_t prio;
-#endif
+	/* Fair and stride policies: node in the run queue tree, sort key */
+	struct rb_node run_node;
+	uint64_t vruntime;
+	/* Time slots for the turnaround and waiting time statistics */
+	uint64_t arrival;
+	uint64_t exec_start;
+	uint64_t sum_exec;
+	uint32_t slice;		 // Time slots granted at the last dispatch
+	/* Real time: absolute deadline, 0 for none, and EDF admission */
+	uint64_t deadline;
+	int rt;
+	/* MLFQ feedback: level and READ/WRITE/SYSCALL instructions run */
+	int level;
+	uint32_t nr_io;
+	uint32_t nr_io_seen;
+	/* Set by the sleep system call, 0 while awake; then parked on the
+	 * timing wheel until that time slot */
+	uint64_t sleep_until;
+	struct wheel_timer sleep_timer;
 	
 #ifdef MM_PAGING
     struct mm_struct *mm;
@@ -126,11 +179,9 @@ struct pcb_t
 /* Kernel structure */
 struct krnl_t
 {
-	struct queue_t *ready_queue;
-	struct queue_t *running_list;
-#ifdef MLQ_SCHED
-	struct queue_t *mlq_ready_queue;
-#endif
+	struct queue_t *running_list;	/* one running list per CPU */
+	pthread_mutex_t *running_lock;	/* guards running_list[cpu] */
+	int nr_cpus;
 #ifdef MM_PAGING
 	struct mm_struct *mm;
 	struct memphy_struct *mram;
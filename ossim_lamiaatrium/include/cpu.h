@@ -9,5 +9,10 @@
  * Otherwise, return 1. */
 int run(struct pcb_t * proc);
 
+/* Execute the run of CALC at the program counter of a process in one
+ * step, at most [max] instructions of it. Return how many were
+ * executed, 0 if the next instruction needs run(). */
+int run_batch(struct pcb_t * proc, int max);
+
 #endif
 
@@ -3,7 +3,37 @@
 
 #include "common.h"
 
+/*
+ * Binary process image, as tools/procc writes it: this header, then the
+ * decoded and fused ops at file offset [text] and the wide operands at
+ * [wide]. The loader maps the image and runs the ops in place, so an
+ * image only loads on a build with the same version, struct op_t and
+ * byte order as the procc that wrote it.
+ */
+#define PROC_IMAGE_MAGIC "\177OSP"
+#define PROC_IMAGE_VERSION 2
+
+struct proc_image_hdr {
+	char magic[4];
+	uint32_t version;
+	uint32_t op_size;	/* sizeof(struct op_t) */
+	uint32_t priority;
+	uint32_t size;		/* ops */
+	uint32_t nr_wide;
+	uint64_t text;
+	uint64_t wide;
+};
+
+/* Load the program at [path], a text program or a binary image, into
+ * [code] */
+void load_code(const char * path, struct code_seg_t * code,
+	uint32_t * priority);
+
+/* Shared, read only code segment of the program at [path], loaded on
+ * first use. Every get_code() is paired with a put_code() */
+struct code_seg_t * get_code(const char * path, uint32_t * priority);
+void put_code(struct code_seg_t * code);
+
 struct pcb_t * load(const char * path);
 
 #endif
-
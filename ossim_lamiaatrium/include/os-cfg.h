@@ -11,15 +11,43 @@
 #ifndef OSCFG_H
 #define OSCFG_H
 
-#define MLQ_SCHED 1
+/* Scheduling policy unless "os -s <policy>" picks another one */
+#define SCHED_POLICY "mlq"
 #define MAX_PRIO 140
 
+/* Simulation engine unless "os -e <engine>" picks another one: one
+ * thread per CPU ("threads"), all of them in one thread ("single") or
+ * shared by one thread per host core ("pool") */
+#define SIM_ENGINE "threads"
+
+/* Most instructions of a CALC run a CPU runs in a row without meeting
+ * the other devices at the time slot barrier, 1 to meet them at every
+ * slot */
+#define CPU_BATCH 8
+
+/* Processes the loader reads and sets up ahead of their arrival */
+#define LOADER_PREFETCH 64
+
+/* Process lines of the config file read ahead to sort them by start
+ * time: lines further out of order than that arrive late */
+#define ARRIVAL_WINDOW 1024
+
+/*
+ * Uncomment to hand new processes to the CPUs through a lock-free
+ * MPMC ring (struct lfqueue_t) instead of taking the run queue lock
+ */
+// #define QUEUE_LOCKFREE 1
+
 #define MM_PAGING
 // #define MM_FIXED_MEMSZ
 //#define VMDBG 1
 //#define MMDBG 1
+/* "make bench" builds with -DNO_IODUMP, to time the simulation
+ * rather than the page table dumps */
+#ifndef NO_IODUMP
 #define IODUMP 1
 #define PAGETBL_DUMP 1
+#endif
 
 /* 
  * @bksysnet:
@@ -12,6 +12,7 @@
 #define OSMM_H
 
 #include <stdint.h>
+#include <sys/types.h>
 
 #define MM_PAGING
 #define PAGING_MAX_MMSWP 4 /* max number of supported swapped space */
@@ -99,6 +100,9 @@ struct mm_struct {
 
    /* list of free page */
    struct pgn_t *fifo_pgn;
+
+   /* Serializes the region management and page table of this mm */
+   pthread_mutex_t lock;
 };
 
 /*
@@ -124,6 +128,9 @@ struct memphy_struct {
    /* Management structure */
    struct framephy_struct *free_fp_list;
    struct framephy_struct *used_fp_list;
+
+   /* Spin lock over the frame lists and the sequential cursor */
+   volatile int lock;
 };
 
 #endif
\ No newline at end of file
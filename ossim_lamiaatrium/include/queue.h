@@ -1,26 +1,62 @@
-
 #ifndef QUEUE_H
 #define QUEUE_H
 
 #include "common.h"
 
-#define MAX_QUEUE_SIZE 50
+#define MAX_QUEUE_SIZE 50	/* initial capacity, queues grow past it */
 
+/*
+ * Growable ring of PCBs. head and tail are running positions, a slot
+ * is proc[pos & (cap - 1)] and cap is always a power of two, so the
+ * storage can double without moving a process to another position.
+ * A zero filled queue_t is a valid empty queue. Callers lock.
+ */
 struct queue_t {
-	struct pcb_t * proc[MAX_QUEUE_SIZE];
-	
- 	int head;   /* index of first element */
-    int tail;   /* index one-past-last element */
-    int size;   /* number of elements */
+	struct pcb_t ** proc;
+	unsigned long head;	/* position of first element */
+	unsigned long tail;	/* position one-past-last element */
+	int size;		/* number of elements */
+	int cap;		/* slots in proc[], 0 until first enqueue */
 };
 
 void enqueue(struct queue_t * q, struct pcb_t * proc);
 
 struct pcb_t * dequeue(struct queue_t * q);
 
+/* Remove [proc] from [q] in O(1) through proc->qpos, leaving a hole
+ * that dequeue skips */
 struct pcb_t *purgequeue(struct queue_t *q, struct pcb_t *proc);
 
 int empty(struct queue_t * q);
 
+/* Process [pid] in [q], NULL if none */
+struct pcb_t *queue_find(struct queue_t *q, uint32_t pid);
+
+#ifdef QUEUE_LOCKFREE
+/*
+ * Bounded multi-producer/multi-consumer ring (D. Vyukov). Each cell
+ * carries a sequence number telling whether it is ready for the
+ * enqueuer or the dequeuer at a given position, so no lock is needed.
+ * A zero filled lfqueue_t is a valid empty queue: seq[i] is stored
+ * relative to the cell index i.
+ */
+#define LFQUEUE_CAPACITY 64	/* power of two */
+
+struct lfqueue_t {
+	struct pcb_t * proc[LFQUEUE_CAPACITY];
+	unsigned long seq[LFQUEUE_CAPACITY];
+
+	unsigned long head __attribute__((aligned(64))); /* next pos to dequeue */
+	unsigned long tail __attribute__((aligned(64))); /* next pos to enqueue */
+	int size __attribute__((aligned(64)));           /* number of elements */
+};
+
+/* Returns -1 without queueing [proc] when the ring is full */
+int lfq_enqueue(struct lfqueue_t * q, struct pcb_t * proc);
+
+struct pcb_t * lfq_dequeue(struct lfqueue_t * q);
+
+int lfq_empty(struct lfqueue_t * q);
 #endif
 
+#endif
@@ -0,0 +1,45 @@
+#ifndef RBTREE_H
+#define RBTREE_H
+
+#include <stddef.h>
+
+/*
+ * Intrusive red-black tree, the node lives inside the object it sorts.
+ * Insertion is done by the caller in two steps like in Linux: walk down
+ * to find the parent and link, rb_link_node() then rb_insert_color().
+ */
+#define RB_RED		0
+#define RB_BLACK	1
+
+struct rb_node {
+	struct rb_node *parent;
+	struct rb_node *left;
+	struct rb_node *right;
+	int color;
+};
+
+struct rb_root {
+	struct rb_node *node;
+};
+
+#define rb_entry(ptr, type, member) \
+	((type *)((char *)(ptr) - offsetof(type, member)))
+
+static inline void rb_link_node(struct rb_node *node, struct rb_node *parent,
+				struct rb_node **link) {
+	node->parent = parent;
+	node->left = node->right = NULL;
+	node->color = RB_RED;
+	*link = node;
+}
+
+/* Rebalance after rb_link_node() */
+void rb_insert_color(struct rb_node *node, struct rb_root *root);
+
+void rb_erase(struct rb_node *node, struct rb_root *root);
+
+/* Smallest and largest node, NULL for an empty tree */
+struct rb_node *rb_first(struct rb_root *root);
+struct rb_node *rb_last(struct rb_root *root);
+
+#endif
@@ -3,26 +3,120 @@
 
 #include "common.h"
 
-#ifndef MLQ_SCHED
-#define MLQ_SCHED
+#ifndef MAX_PRIO
+#define MAX_PRIO 140
 #endif
 
-#define MAX_PRIO 140
+/* Dispatches between two load balancing passes of a CPU */
+#define SCHED_REBALANCE_INTERVAL 16
+/* Upper bound of processes migrated by one balancing pass */
+#define SCHED_MIGRATE_BATCH 8
+
+/*
+ * A scheduling policy. Every CPU run queue owns one private state
+ * object of the policy, made by init(). add, put, get, steal and pull
+ * run under that run queue's lock; tick and migrate run on a process
+ * owned by the calling CPU. migrate and tick may be NULL.
+ */
+struct sched_ops {
+	const char * name;
+	void * (*init)(void);
+	/* A new process arrives */
+	void (*add)(void * rq, struct pcb_t * proc);
+	/* A process comes back from a CPU at the end of its slice */
+	void (*put)(void * rq, struct pcb_t * proc);
+	/* Next process to dispatch, NULL if none is due */
+	struct pcb_t * (*get)(void * rq);
+	/* Process to hand to an idle peer, and one to move off a busy queue */
+	struct pcb_t * (*steal)(void * rq);
+	struct pcb_t * (*pull)(void * rq);
+	/* Ready process [pid], left in place, NULL if none */
+	struct pcb_t * (*find)(void * rq, uint32_t pid);
+	/* [proc] ran for [slots] time slots */
+	void (*tick)(struct pcb_t * proc, uint64_t slots);
+	/* [proc] moves from run queue state [from] to [to] */
+	void (*migrate)(struct pcb_t * proc, void * from, void * to);
+	/* Time slots [proc] may run when dispatched, time_slot if NULL */
+	int (*quantum)(struct pcb_t * proc, int time_slot);
+	/* Urgency of [proc], lower runs first. A new arrival preempts a
+	 * running process of higher rank; no preemption if NULL */
+	long (*rank)(struct pcb_t * proc);
+};
+
+extern const struct sched_ops fifo_sched_ops;
+extern const struct sched_ops mlq_sched_ops;
+extern const struct sched_ops mlfq_sched_ops;
+extern const struct sched_ops stride_sched_ops;
+extern const struct sched_ops cfs_sched_ops;
+
+/* Select the policy by name ("mlq", "fifo", "mlfq", ...), -1 if
+ * unknown. Call it before init_scheduler() */
+int set_sched_policy(const char * name);
+
+/* Names of the registered policies, NULL terminated */
+const char * const * sched_policy_names(void);
+
+/* Helpers for the policies keeping ready processes sorted by vruntime */
+void vtree_insert(struct rb_root * tree, struct pcb_t * proc);
+struct pcb_t * vtree_take(struct rb_root * tree, struct rb_node * node);
+struct pcb_t * vtree_find(struct rb_root * tree, uint32_t pid);
+
+/*
+ * Earliest deadline first class, ahead of the policy on every CPU.
+ * Callers hold the run queue lock.
+ */
+#define EDF_DENSITY_ONE 1024
+
+struct edf_rq {
+	struct pcb_t ** heap;		/* min-heap by pcb_t.deadline */
+	int nr, cap;
+	long density;			/* sum of admitted C/D, in 1/1024 */
+};
 
+/* Reserve [proc]'s density on [rq], -1 if it does not fit */
+int edf_admit(struct edf_rq * rq, struct pcb_t * proc);
+void edf_release(struct edf_rq * rq, struct pcb_t * proc);
+void edf_push(struct edf_rq * rq, struct pcb_t * proc);
+struct pcb_t * edf_pop(struct edf_rq * rq);
+struct pcb_t * edf_find(struct edf_rq * rq, uint32_t pid);
+
+/* Return 1 if no process waits in any run queue */
 int queue_empty(void);
 
-void init_scheduler(void);
+void init_scheduler(int nr_cpus);
 void finish_scheduler(void);
 
-/* Get the next process from ready queue */
-struct pcb_t * get_proc(void);
+/* Get the next process for [cpu] from its run queue or a peer's */
+struct pcb_t * get_proc(int cpu);
+
+/* Time slots a process just dispatched may run, [time_slot] is the
+ * configured default */
+int get_quantum(struct pcb_t * proc, int time_slot);
+
+/* Non zero when [cpu] should give up its process at the next
+ * instruction boundary, for a more urgent arrival */
+int need_resched(int cpu);
+
+/* Process [pid] waiting in some run queue, NULL if none */
+struct pcb_t * find_ready_proc(uint32_t pid);
 
-/* Put a process back to run queue */
+/* Put a process back to the run queue of the CPU it ran on */
 void put_proc(struct pcb_t * proc);
 
-/* Add a new process to ready queue */
+/* Add a new process to the least loaded run queue */
 void add_proc(struct pcb_t * proc);
 
-#endif
+/* Take a process off its CPU until time slot proc->sleep_until, when it
+ * goes back to that CPU's run queue */
+void sleep_proc(struct pcb_t * proc);
+
+/* Return 1 while some process sleeps */
+int proc_asleep(void);
 
+/* Take a finished process off its CPU and account its statistics */
+void finish_proc(struct pcb_t * proc);
 
+/* Turnaround and waiting time of the finished processes */
+void print_sched_stats(void);
+
+#endif
@@ -43,3 +43,6 @@ int libsyscall(struct pcb_t*, uint32_t, arg_t, arg_t, arg_t);
 int syscall(struct krnl_t*, uint32_t, uint32_t, struct sc_regs*);
 int __sys_ni_syscall(struct krnl_t*, struct sc_regs*);
 
+/* The running process [pid], NULL if none */
+struct pcb_t *find_proc_safe(struct krnl_t*, uint32_t pid);
+
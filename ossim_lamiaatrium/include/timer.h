@@ -4,13 +4,15 @@
 #include <pthread.h>
 #include <stdint.h>
 
+#include "wheel.h"
+
+/* Wake up time of a device waiting for nothing */
+#define TIMER_NEVER UINT64_MAX
+
 struct timer_id_t {
-	int done;
-	int fsh;
-	pthread_cond_t event_cond;
-	pthread_mutex_t event_lock;
-	pthread_cond_t timer_cond;
-	pthread_mutex_t timer_lock;
+	int fsh;	/* detached, done with the time slots */
+	uint64_t wake;	/* time slot the device runs next */
+	int idle;	/* runs at every time slot the clock stops at */
 };
 
 void start_timer();
@@ -23,6 +25,20 @@ void detach_event(struct timer_id_t * event);
 
 void next_slot(struct timer_id_t* timer_id);
 
+/* Like next_slot(), for a device with nothing to do before time slot
+ * [wake]: it sleeps until then, and when every device sleeps the clock
+ * skips ahead. With TIMER_NEVER the device has no work of its own; it
+ * runs at every time slot the clock stops at, but never holds it back */
+void next_slot_at(struct timer_id_t * timer_id, uint64_t wake);
+
+/* Like next_slot_at(), for a device which may find work at any time
+ * slot the clock stops at before [wake] */
+void next_slot_idle(struct timer_id_t * timer_id, uint64_t wake);
+
 uint64_t current_time();
 
+/* Call event->fn when the clock reaches time slot event->expires. The
+ * callback runs while every device waits at the time slot barrier */
+void timer_add(struct wheel_timer * event);
+
 #endif
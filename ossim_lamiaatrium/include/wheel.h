@@ -0,0 +1,48 @@
+#ifndef WHEEL_H
+#define WHEEL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Hierarchical timing wheel, after Varghese and Lauck. Level l has
+ * WHEEL_SIZE slots of WHEEL_SIZE^l time slots each; a timer sits on
+ * the lowest level whose span covers its distance to now, and moves
+ * down a level each time the clock reaches its slot. Adding and
+ * removing a timer is O(1), so is the work per time slot apart from
+ * the timers moving down. The timer lives inside the object it wakes.
+ * Callers lock.
+ */
+#define WHEEL_BITS	6
+#define WHEEL_SIZE	(1 << WHEEL_BITS)
+#define WHEEL_MASK	(WHEEL_SIZE - 1)
+#define WHEEL_LEVELS	4
+
+struct wheel_timer {
+	struct wheel_timer *next;
+	struct wheel_timer **pprev;	/* NULL while not pending */
+	uint64_t expires;		/* time slot to fire in */
+	void (*fn)(struct wheel_timer *timer);
+};
+
+struct timing_wheel {
+	uint64_t now;			/* next time slot to process */
+	uint64_t pending[WHEEL_LEVELS];	/* bit s set while slot s has timers */
+	struct wheel_timer *slot[WHEEL_LEVELS][WHEEL_SIZE];
+};
+
+#define wheel_entry(ptr, type, member) \
+	((type *)((char *)(ptr) - offsetof(type, member)))
+
+/* An all zero wheel is an empty one starting at time slot 0 */
+void wheel_add(struct timing_wheel *wheel, struct wheel_timer *timer);
+void wheel_del(struct timing_wheel *wheel, struct wheel_timer *timer);
+
+/* Fire every timer due up to time slot [now], in expiry order */
+void wheel_advance(struct timing_wheel *wheel, uint64_t now);
+
+/* A time slot no later than the first pending expiry, UINT64_MAX if
+ * no timer is pending */
+uint64_t wheel_next(struct timing_wheel *wheel);
+
+#endif
@@ -58,55 +58,96 @@ int write(
 	return write_mem(proc->regs[destination] + offset, proc, data);
 }
 
+/*
+ * The loader decoded every instruction into a struct op_t, so run()
+ * jumps straight to the handler of the op at the program counter
+ * through a table of label addresses, without copying the instruction.
+ */
 int run(struct pcb_t *proc)
 {
+	static const void *const handlers[] = {
+		[CALC] = &&do_calc,
+		[ALLOC] = &&do_alloc,
+		[FREE] = &&do_free,
+		[READ] = &&do_read,
+		[WRITE] = &&do_write,
+		[SYSCALL] = &&do_syscall,
+		[SYSCALL_WIDE] = &&do_syscall_wide,
+	};
+	const struct op_t *op;
+
 	/* Check if Program Counter point to the proper instruction */
 	if (proc->pc >= proc->code->size)
 	{
 		return 1;
 	}
 
-	struct inst_t ins = proc->code->text[proc->pc];
+	op = &proc->code->text[proc->pc];
 	proc->pc++;
-	int stat = 1;
-switch (ins.opcode)
-	{
-	case CALC:
-		stat = calc(proc);
-		break;
-	case ALLOC:
+	goto *handlers[op->handler];
+
+do_calc:
+	return calc(proc);
+
+do_alloc:
 #ifdef MM_PAGING
-		stat = liballoc(proc, ins.arg_0, ins.arg_1);
+	return liballoc(proc, op->b, op->a);
 #else
-		stat = alloc(proc, ins.arg_0, ins.arg_1);
+	return alloc(proc, op->b, op->a);
 #endif
-		break;
-	case FREE:
+
+do_free:
 #ifdef MM_PAGING
-		stat = libfree(proc, ins.arg_0);
+	return libfree(proc, op->a);
 #else
-		stat = free_data(proc, ins.arg_0);
+	return free_data(proc, op->a);
 #endif
-		break;
-	case READ:
+
+do_read:
+	proc->nr_io++;
 #ifdef MM_PAGING
-		stat = libread(proc, ins.arg_0, ins.arg_1, (uint32_t*) &ins.arg_2);
+	{
+		uint32_t data;
+		return libread(proc, op->a, op->b, &data);
+	}
 #else
-		stat = read(proc, ins.arg_0, ins.arg_1, ins.arg_2);
+	return read(proc, op->a, op->b, op->c);
 #endif
-		break;
-	case WRITE:
+
+do_write:
+	proc->nr_io++;
 #ifdef MM_PAGING
-		stat = libwrite(proc, ins.arg_0, ins.arg_1, ins.arg_2);
+	return libwrite(proc, op->a, op->c, op->b);
 #else
-		stat = write(proc, ins.arg_0, ins.arg_1, ins.arg_2);
+	return write(proc, op->a, op->c, op->b);
 #endif
-		break;
-	case SYSCALL:
-		stat = libsyscall(proc, ins.arg_0, ins.arg_1, ins.arg_2, ins.arg_3);
-		break;
-	default:
-		stat = 1;
+
+do_syscall:
+	proc->nr_io++;
+	return libsyscall(proc, op->a, op->b, op->c, 0);
+
+do_syscall_wide:
+	proc->nr_io++;
+	{
+		const arg_t *arg = &proc->code->wide[op->b];
+		return libsyscall(proc, op->a, arg[0], arg[1], arg[2]);
 	}
-	return stat;
+}
+
+int run_batch(struct pcb_t *proc, int max)
+{
+	const struct op_t *op;
+	int n;
+
+	if (proc->pc >= proc->code->size)
+		return 0;
+	op = &proc->code->text[proc->pc];
+	if (op->handler != CALC)
+		return 0;
+
+	/* calc() has no effect, once stands for the run */
+	n = (op->b < (arg_t)max) ? (int)op->b : max;
+	calc(proc);
+	proc->pc += n;
+	return n;
 }
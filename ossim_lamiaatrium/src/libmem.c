@@ -23,7 +23,6 @@
 #include <stdio.h>
 #include <pthread.h>
 
-static pthread_mutex_t mmvm_lock = PTHREAD_MUTEX_INITIALIZER;
 
 /*enlist_vm_freerg_list - add new rg to freerg_list
  *@mm: memory region
@@ -72,18 +71,17 @@ struct vm_rg_struct *get_symrg_byid(struct mm_struct *mm, int rgid)
 int __alloc(struct pcb_t *caller, int vmaid, int rgid, addr_t size, addr_t *alloc_addr)
 {
   /*Allocate at the toproof */
-  pthread_mutex_lock(&mmvm_lock);
   struct vm_rg_struct rgnode;
 
   if (caller == NULL || caller->mm == NULL) {
-      pthread_mutex_unlock(&mmvm_lock);
       return -1;
   }
+  pthread_mutex_lock(&caller->mm->lock);
 
   struct vm_area_struct *cur_vma = get_vma_by_num(caller->mm, vmaid);
 
   if(cur_vma == NULL){
-    pthread_mutex_unlock(&mmvm_lock);
+    pthread_mutex_unlock(&caller->mm->lock);
     return -1;
   }
 
@@ -92,7 +90,7 @@ int __alloc(struct pcb_t *caller, int vmaid, int rgid, addr_t size, addr_t *allo
     caller->mm->symrgtbl[rgid].rg_start = rgnode.rg_start;
     caller->mm->symrgtbl[rgid].rg_end = rgnode.rg_end;
     *alloc_addr = rgnode.rg_start;
-    pthread_mutex_unlock(&mmvm_lock);
+    pthread_mutex_unlock(&caller->mm->lock);
     return 0;
   }
 
@@ -110,7 +108,7 @@ int __alloc(struct pcb_t *caller, int vmaid, int rgid, addr_t size, addr_t *allo
   old_sbrk = cur_vma->sbrk;
 
   if(old_sbrk + aligned_size > cur_vma->vm_end){
-    pthread_mutex_unlock(&mmvm_lock);
+    pthread_mutex_unlock(&caller->mm->lock);
     return -1;
   }
 
@@ -128,7 +126,7 @@ int __alloc(struct pcb_t *caller, int vmaid, int rgid, addr_t size, addr_t *allo
   int sc_res = syscall(caller->krnl, caller->pid, 17, &regs); /* SYSCALL 17 sys_memmap */
   if (sc_res < 0)
   {
-    pthread_mutex_unlock(&mmvm_lock);
+    pthread_mutex_unlock(&caller->mm->lock);
     return -1;
   }
   /*Successful increase limit */
@@ -138,7 +136,7 @@ int __alloc(struct pcb_t *caller, int vmaid, int rgid, addr_t size, addr_t *allo
 
   *alloc_addr = old_sbrk;
 
-  pthread_mutex_unlock(&mmvm_lock);
+  pthread_mutex_unlock(&caller->mm->lock);
   return 0;
 
 }
@@ -152,19 +150,17 @@ int __alloc(struct pcb_t *caller, int vmaid, int rgid, addr_t size, addr_t *allo
  */
 int __free(struct pcb_t *caller, int vmaid, int rgid)
 {
-  pthread_mutex_lock(&mmvm_lock);
-
   if (rgid < 0 || rgid >= PAGING_MAX_SYMTBL_SZ)
   {
-    pthread_mutex_unlock(&mmvm_lock);
     return -1;
   }
+  pthread_mutex_lock(&caller->mm->lock);
 
   struct vm_rg_struct *rgnode = get_symrg_byid(caller->mm, rgid);
 
   if (rgnode->rg_start == 0 && rgnode->rg_end == 0)
   {
-    pthread_mutex_unlock(&mmvm_lock);
+    pthread_mutex_unlock(&caller->mm->lock);
     return -1;
   }
 
@@ -222,7 +218,7 @@ int __free(struct pcb_t *caller, int vmaid, int rgid)
       }
   }
 
-  pthread_mutex_unlock(&mmvm_lock);
+  pthread_mutex_unlock(&caller->mm->lock);
   return 0;
 }
 
@@ -289,6 +285,13 @@ int libfree(struct pcb_t *proc, uint32_t reg_index)
   return val;
 }
 
+static unsigned long page_fault_count = 0;
+
+unsigned long nr_page_faults(void)
+{
+  return page_fault_count;
+}
+
 /*pg_getpage - get the page in ram
  *@mm: memory region
  *@pagenum: PGN
@@ -302,19 +305,45 @@ int pg_getpage(struct mm_struct *mm, int pgn, int *fpn, struct pcb_t *caller)
 
   if (!PAGING_PAGE_PRESENT(pte))
   { 
-    /* Page Fault */
-    addr_t vicpgn;
+    /* Page Fault: take a free frame, else evict the oldest page of
+     * this mm to swap and reuse its frame */
+    addr_t tgtfpn, vicpgn, swpfpn;
+
+    __sync_fetch_and_add(&page_fault_count, 1);
 
-    if (find_victim_page(caller->mm, &vicpgn) == -1) {
-       return -1; 
+    if (MEMPHY_get_freefp(caller->krnl->mram, &tgtfpn) < 0)
+    {
+      if (MEMPHY_get_freefp(caller->krnl->active_mswp, &swpfpn) < 0) {
+        printf("pg_getpage: PID %d page %d: swap is full\n", caller->pid, pgn);
+        return -1;
+      }
+      if (find_victim_page(caller->mm, &vicpgn) == -1) {
+        MEMPHY_put_freefp(caller->krnl->active_mswp, swpfpn);
+        printf("pg_getpage: PID %d page %d: no free frame and no page to evict\n",
+               caller->pid, pgn);
+        return -1; 
+      }
+      tgtfpn = PAGING_FPN(pte_get_entry(caller, vicpgn));
+
+      /* Copy the victim frame out to swap */
+      struct sc_regs regs;
+      regs.a1 = SYSMEM_SWP_OP;
+      regs.a2 = tgtfpn; // Victim FPN
+      regs.a3 = swpfpn; // Swap FPN
+      
+      syscall(caller->krnl, caller->pid, 17, &regs);
+      pte_set_swap(caller, vicpgn, 0, swpfpn);
     }
 
-    struct sc_regs regs;
-    regs.a1 = SYSMEM_SWP_OP;
-    regs.a2 = vicpgn; // Victim PGN
-    regs.a3 = pgn;    // Target PGN
-    
-    syscall(caller->krnl, caller->pid, 17, &regs);
+    /* Bring the target page in if it was swapped out */
+    if (pte & PAGING_PTE_SWAPPED_MASK)
+    {
+      swpfpn = PAGING_SWP(pte);
+      __swap_cp_page(caller->krnl->active_mswp, swpfpn,
+                     caller->krnl->mram, tgtfpn);
+      MEMPHY_put_freefp(caller->krnl->active_mswp, swpfpn);
+    }
+    pte_set_fpn(caller, pgn, tgtfpn);
 
     enlist_pgn_node(&caller->mm->fifo_pgn, pgn);
   }
@@ -390,18 +419,18 @@ int pg_setval(struct mm_struct *mm, int addr, BYTE value, struct pcb_t *caller)
  */
 int __read(struct pcb_t *caller, int vmaid, int rgid, addr_t offset, BYTE *data)
 {
-  pthread_mutex_lock(&mmvm_lock);
+  pthread_mutex_lock(&caller->mm->lock);
   struct vm_rg_struct *currg = get_symrg_byid(caller->mm, rgid);
 
   if (currg == NULL || offset < 0 || offset >= (currg->rg_end - currg->rg_start))
   {
-    pthread_mutex_unlock(&mmvm_lock);
+    pthread_mutex_unlock(&caller->mm->lock);
     return -1;
   }
 
-  pg_getval(caller->mm, currg->rg_start + offset, data, caller);
-  pthread_mutex_unlock(&mmvm_lock);
-  return 0;
+  int val = pg_getval(caller->mm, currg->rg_start + offset, data, caller);
+  pthread_mutex_unlock(&caller->mm->lock);
+  return val;
 }
 
 /*libread - PAGING-based read a region memory */
@@ -436,21 +465,21 @@ int libread(
  */
 int __write(struct pcb_t *caller, int vmaid, int rgid, addr_t offset, BYTE value)
 {
-  pthread_mutex_lock(&mmvm_lock);
+  pthread_mutex_lock(&caller->mm->lock);
   
   struct vm_rg_struct *currg = get_symrg_byid(caller->mm, rgid);
   struct vm_area_struct *cur_vma = get_vma_by_num(caller->mm, vmaid);
 
   if (currg == NULL || cur_vma == NULL || offset < 0 || offset >= currg->rg_end - currg->rg_start)
   {
-    pthread_mutex_unlock(&mmvm_lock);
+    pthread_mutex_unlock(&caller->mm->lock);
     return -1;
   }
 
-  pg_setval(caller->mm, currg->rg_start + offset, value, caller);
+  int val = pg_setval(caller->mm, currg->rg_start + offset, value, caller);
 
-  pthread_mutex_unlock(&mmvm_lock);
-  return 0;
+  pthread_mutex_unlock(&caller->mm->lock);
+  return val;
 }
 
 /*libwrite - PAGING-based write a region memory */
@@ -484,7 +513,7 @@ int libwrite(
  */
 int free_pcb_memphy(struct pcb_t *caller)
 {
-  pthread_mutex_lock(&mmvm_lock);
+  pthread_mutex_lock(&caller->mm->lock);
   int pagenum, fpn;
   uint32_t pte;
 
@@ -504,7 +533,7 @@ int free_pcb_memphy(struct pcb_t *caller)
     }
   }
 
-  pthread_mutex_unlock(&mmvm_lock);
+  pthread_mutex_unlock(&caller->mm->lock);
   return 0;
 }
 
@@ -3,6 +3,9 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 static uint32_t avail_pid = 1;
 
@@ -32,71 +35,351 @@ static enum ins_opcode_t get_opcode(char * opt) {
 	}
 }
 
-struct pcb_t * load(const char * path) {
-	/* Create new PCB for the new process */
-	struct pcb_t * proc = (struct pcb_t * )malloc(sizeof(struct pcb_t));
-	proc->pid = avail_pid;
-	avail_pid++;
-	proc->page_table =
-		(struct page_table_t*)malloc(sizeof(struct page_table_t));
-	proc->bp = PAGE_SIZE;
-	proc->pc = 0;
+/* Pack [ins] into the form run() dispatches on, see struct op_t */
+static void decode(struct code_seg_t * code, struct op_t * op,
+		const struct inst_t * ins) {
+	op->handler = ins->opcode;
+	op->c = 0;
+	op->a = 0;
+	op->b = 0;
+	switch (ins->opcode) {
+	case CALC:
+		break;
+	case ALLOC:
+		op->a = ins->arg_1;
+		op->b = ins->arg_0;
+		break;
+	case FREE:
+		op->a = ins->arg_0;
+		break;
+	case READ:
+		op->a = ins->arg_0;
+		op->b = ins->arg_1;
+		op->c = ins->arg_2;
+		break;
+	case WRITE:
+		op->a = ins->arg_0;
+		op->b = ins->arg_2;
+		op->c = ins->arg_1;
+		break;
+	case SYSCALL:
+		op->a = ins->arg_0;
+		if (ins->arg_2 <= UINT16_MAX && ins->arg_3 == 0) {
+			op->b = ins->arg_1;
+			op->c = ins->arg_2;
+			break;
+		}
+		op->handler = SYSCALL_WIDE;
+		op->b = code->nr_wide;
+		code->wide = realloc(code->wide,
+			sizeof(arg_t) * (code->nr_wide + 3));
+		code->wide[code->nr_wide++] = ins->arg_1;
+		code->wide[code->nr_wide++] = ins->arg_2;
+		code->wide[code->nr_wide++] = ins->arg_3;
+		break;
+	}
+}
 
-	/* Read process code from file */
-	FILE * file;
-	if ((file = fopen(path, "r")) == NULL) {
-		printf("Cannot find process description at '%s'\n", path);
-		exit(1);		
+/*
+ * Peephole pass over a decoded program: give each CALC the length of
+ * its run, so run_batch() can take the run in one dispatch. Nothing
+ * else is fused: a memory access may page fault, which must happen in
+ * its own time slot.
+ */
+static void fuse(struct code_seg_t * code) {
+	struct op_t * op;
+	arg_t calc_run = 0;
+	uint32_t i;
+
+	for (i = code->size; i-- > 0; ) {
+		op = &code->text[i];
+		if (op->handler == CALC) {
+			op->b = ++calc_run;
+			continue;
+		}
+		calc_run = 0;
 	}
-	snprintf(proc->path, 2*sizeof(path)+1, "%s", path);
+}
+
+/* Decode the text program in [file] into [code] */
+static void parse(FILE * file, struct code_seg_t * code, uint32_t * priority) {
 	char opcode[10];
-	proc->code = (struct code_seg_t*)malloc(sizeof(struct code_seg_t));
-	fscanf(file, "%u %u", &proc->priority, &proc->code->size);
-	proc->code->text = (struct inst_t*)malloc(
-		sizeof(struct inst_t) * proc->code->size
+
+	/* No header (e.g. a directory): an empty program */
+	if (fscanf(file, "%u %u", priority, &code->size) != 2) {
+		*priority = 0;
+		code->size = 0;
+	}
+	code->text = (struct op_t*)malloc(
+		sizeof(struct op_t) * code->size
 	);
+	code->wide = NULL;
+	code->nr_wide = 0;
+	code->image = NULL;
+	code->image_size = 0;
 	uint32_t i = 0;
 	char buf[200];
-	for (i = 0; i < proc->code->size; i++) {
+	struct inst_t ins;
+	for (i = 0; i < code->size; i++) {
 		fscanf(file, "%s", opcode);
-		proc->code->text[i].opcode = get_opcode(opcode);
-		switch(proc->code->text[i].opcode) {
+		ins.opcode = get_opcode(opcode);
+		ins.arg_0 = ins.arg_1 = ins.arg_2 = ins.arg_3 = 0;
+		switch(ins.opcode) {
 		case CALC:
 			break;
 		case ALLOC:
 			fscanf(
 				file,
 				"" FORMAT_ARG " " FORMAT_ARG "\n",
-				&proc->code->text[i].arg_0,
-				&proc->code->text[i].arg_1
+				&ins.arg_0,
+				&ins.arg_1
 			);
 			break;
 		case FREE:
-			fscanf(file, "" FORMAT_ARG "\n", &proc->code->text[i].arg_0);
+			fscanf(file, "" FORMAT_ARG "\n", &ins.arg_0);
 			break;
 		case READ:
 		case WRITE:
 			fscanf(
 				file,
 				"" FORMAT_ARG " " FORMAT_ARG " " FORMAT_ARG "\n",
-				&proc->code->text[i].arg_0,
-				&proc->code->text[i].arg_1,
-				&proc->code->text[i].arg_2
+				&ins.arg_0,
+				&ins.arg_1,
+				&ins.arg_2
 			);
 			break;	
 		case SYSCALL:
 			fgets(buf, sizeof(buf), file);
 			sscanf(buf, "" FORMAT_ARG "" FORMAT_ARG "" FORMAT_ARG "" FORMAT_ARG "",
-			           &proc->code->text[i].arg_0,
-			           &proc->code->text[i].arg_1,
-			           &proc->code->text[i].arg_2,
-			           &proc->code->text[i].arg_3
+			           &ins.arg_0,
+			           &ins.arg_1,
+			           &ins.arg_2,
+			           &ins.arg_3
 			);
 			break;
 		default:
 			printf("Opcode: %s\n", opcode);
 			exit(1);
 		}
+		decode(code, &code->text[i], &ins);
 	}
+	fuse(code);
+}
+
+/* run() and run_batch() trust the ops: every handler has a label, a
+ * SYSCALL_WIDE's arguments are in [wide] and a CALC run ends in the
+ * program. Exit on an image that breaks any of that. */
+static void check_ops(const struct code_seg_t * code, const char * path) {
+	const struct op_t * op;
+	uint32_t i;
+
+	for (i = 0; i < code->size; i++) {
+		op = &code->text[i];
+		if (op->handler > SYSCALL_WIDE ||
+		    (op->handler == SYSCALL_WIDE &&
+		     (code->nr_wide < 3 || op->b > code->nr_wide - 3)) ||
+		    (op->handler == CALC && op->b > code->size - i)) {
+			printf("Process image '%s' has a bad op at %u\n",
+				path, i);
+			exit(1);
+		}
+	}
+}
+
+/* Map the binary image [path] is open on into [code], see struct
+ * proc_image_hdr */
+static void map_image(FILE * file, const char * path,
+		struct code_seg_t * code, uint32_t * priority) {
+	struct proc_image_hdr hdr;
+	struct stat st;
+	char * image;
+
+	if (fread(&hdr, sizeof(hdr), 1, file) != 1 ||
+	    fstat(fileno(file), &st) < 0) {
+		printf("Cannot read process image '%s'\n", path);
+		exit(1);
+	}
+	if (hdr.version != PROC_IMAGE_VERSION ||
+	    hdr.op_size != sizeof(struct op_t)) {
+		printf("Process image '%s' was built for another version "
+			"or address mode, rebuild it with procc\n", path);
+		exit(1);
+	}
+	/* The mapping is page aligned, so aligned offsets give aligned
+	 * ops; compare against the room left, the sums may wrap */
+	if (hdr.text % _Alignof(struct op_t) != 0 ||
+	    hdr.wide % _Alignof(arg_t) != 0) {
+		printf("Process image '%s' is misaligned\n", path);
+		exit(1);
+	}
+	if (hdr.text > (uint64_t)st.st_size ||
+	    hdr.size > ((uint64_t)st.st_size - hdr.text) /
+		sizeof(struct op_t) ||
+	    hdr.wide > (uint64_t)st.st_size ||
+	    hdr.nr_wide > ((uint64_t)st.st_size - hdr.wide) /
+		sizeof(arg_t)) {
+		printf("Process image '%s' is truncated\n", path);
+		exit(1);
+	}
+	image = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE,
+		fileno(file), 0);
+	if (image == MAP_FAILED) {
+		printf("Cannot map process image '%s'\n", path);
+		exit(1);
+	}
+
+	/* The ops run in place, nothing writes to a code segment */
+	code->text = (struct op_t*)(image + hdr.text);
+	code->size = hdr.size;
+	code->wide = (arg_t*)(image + hdr.wide);
+	code->nr_wide = hdr.nr_wide;
+	code->image = image;
+	code->image_size = st.st_size;
+	*priority = hdr.priority;
+	check_ops(code, path);
+}
+
+void load_code(const char * path, struct code_seg_t * code,
+		uint32_t * priority) {
+	char magic[sizeof(PROC_IMAGE_MAGIC) - 1];
+	FILE * file;
+
+	if ((file = fopen(path, "r")) == NULL) {
+		printf("Cannot find process description at '%s'\n", path);
+		exit(1);		
+	}
+	if (fread(magic, sizeof(magic), 1, file) == 1 &&
+	    !memcmp(magic, PROC_IMAGE_MAGIC, sizeof(magic))) {
+		rewind(file);
+		map_image(file, path, code, priority);
+	}else{
+		rewind(file);
+		parse(file, code, priority);
+	}
+	fclose(file);
+}
+
+/*
+ * Code segments shared by the PCBs running the same program file, keyed
+ * by its device and inode. A file modified since it was cached gets a
+ * new entry; the old one lives on until its last PCB drops it.
+ */
+#define CODE_CACHE_BUCKETS 64
+
+struct code_cache_t {
+	struct code_seg_t code;		/* first, put_code() gets the entry */
+	dev_t dev;
+	ino_t ino;
+	struct timespec mtime;
+	off_t size;
+	uint32_t priority;
+	int refs;
+	struct code_cache_t * next;
+};
+
+static struct code_cache_t * code_cache[CODE_CACHE_BUCKETS];
+static pthread_mutex_t code_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static struct code_cache_t ** code_bucket(dev_t dev, ino_t ino) {
+	return &code_cache[(ino ^ dev) % CODE_CACHE_BUCKETS];
+}
+
+static void code_unlink(struct code_cache_t * entry) {
+	struct code_cache_t ** pp = code_bucket(entry->dev, entry->ino);
+
+	while (*pp != NULL && *pp != entry)
+		pp = &(*pp)->next;
+	if (*pp != NULL)
+		*pp = entry->next;
+}
+
+struct code_seg_t * get_code(const char * path, uint32_t * priority) {
+	struct code_cache_t * entry, * new_entry, ** bucket;
+	struct stat st;
+
+	if (stat(path, &st) < 0) {
+		printf("Cannot find process description at '%s'\n", path);
+		exit(1);
+	}
+	bucket = code_bucket(st.st_dev, st.st_ino);
+
+	/* Parse without the lock, another thread may race us to it */
+	new_entry = NULL;
+	for (;;) {
+		pthread_mutex_lock(&code_lock);
+		for (entry = *bucket; entry != NULL; entry = entry->next)
+			if (entry->dev == st.st_dev && entry->ino == st.st_ino)
+				break;
+		if (entry != NULL && (entry->size != st.st_size ||
+		    entry->mtime.tv_sec != st.st_mtim.tv_sec ||
+		    entry->mtime.tv_nsec != st.st_mtim.tv_nsec)) {
+			/* Stale */
+			code_unlink(entry);
+			entry = NULL;
+		}
+		if (entry == NULL && new_entry != NULL) {
+			entry = new_entry;
+			entry->next = *bucket;
+			*bucket = entry;
+			new_entry = NULL;
+		}
+		if (entry != NULL) {
+			entry->refs++;
+			pthread_mutex_unlock(&code_lock);
+			break;
+		}
+		pthread_mutex_unlock(&code_lock);
+
+		new_entry = (struct code_cache_t*)malloc(
+			sizeof(struct code_cache_t));
+		load_code(path, &new_entry->code, &new_entry->priority);
+		new_entry->dev = st.st_dev;
+		new_entry->ino = st.st_ino;
+		new_entry->mtime = st.st_mtim;
+		new_entry->size = st.st_size;
+		new_entry->refs = 0;
+	}
+	if (new_entry != NULL) {
+		/* Lost the race */
+		new_entry->refs = 1;
+		put_code(&new_entry->code);
+	}
+	*priority = entry->priority;
+	return &entry->code;
+}
+
+void put_code(struct code_seg_t * code) {
+	struct code_cache_t * entry = (struct code_cache_t*)code;
+
+	pthread_mutex_lock(&code_lock);
+	if (--entry->refs > 0) {
+		pthread_mutex_unlock(&code_lock);
+		return;
+	}
+	code_unlink(entry);
+	pthread_mutex_unlock(&code_lock);
+
+	if (code->image != NULL) {
+		munmap(code->image, code->image_size);
+	}else{
+		free(code->text);
+		free(code->wide);
+	}
+	free(entry);
+}
+
+struct pcb_t * load(const char * path) {
+	/* Create new PCB for the new process */
+	struct pcb_t * proc = (struct pcb_t * )malloc(sizeof(struct pcb_t));
+	proc->pid = avail_pid;
+	avail_pid++;
+	proc->page_table =
+		(struct page_table_t*)malloc(sizeof(struct page_table_t));
+	proc->bp = PAGE_SIZE;
+	proc->pc = 0;
+
+	/* Read process code from file */
+	snprintf(proc->path, 2*sizeof(path)+1, "%s", path);
+	proc->code = get_code(path, &proc->priority);
 	return proc;
-}
\ No newline at end of file
+}
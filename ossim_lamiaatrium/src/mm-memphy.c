@@ -19,14 +19,17 @@
 #include <stdlib.h>
 #include <string.h>
 
-static volatile int memphy_lock = 0;
-
-static void enter_critical(void) {
-   while (__sync_lock_test_and_set(&memphy_lock, 1));
+/*
+ * Each device has its own lock. A frame belongs to one mm at a time and
+ * is only accessed under that mm's lock, so random access reads and
+ * writes of the storage go without it.
+ */
+static void enter_critical(struct memphy_struct *mp) {
+   while (__sync_lock_test_and_set(&mp->lock, 1));
 }
 
-static void exit_critical(void) {
-   __sync_lock_release(&memphy_lock);
+static void exit_critical(struct memphy_struct *mp) {
+   __sync_lock_release(&mp->lock);
 }
 
 /*
@@ -79,14 +82,13 @@ int MEMPHY_read(struct memphy_struct *mp, addr_t addr, BYTE *value)
 {
    if (mp == NULL) return -1;
 
-   enter_critical(); 
-
-   if (mp->rdmflg)
+   if (mp->rdmflg) {
       *value = mp->storage[addr];
-   else /* Sequential access device */
+   } else { /* Sequential access device */
+      enter_critical(mp);
       MEMPHY_seq_read(mp, addr, value); 
-
-   exit_critical();
+      exit_critical(mp);
+   }
    
    return 0;
 }
@@ -122,14 +124,13 @@ int MEMPHY_write(struct memphy_struct *mp, addr_t addr, BYTE data)
 {
    if (mp == NULL) return -1;
 
-   enter_critical(); // LOCK
-
-   if (mp->rdmflg)
+   if (mp->rdmflg) {
       mp->storage[addr] = data;
-   else /* Sequential access device */
+   } else { /* Sequential access device */
+      enter_critical(mp); // LOCK
       MEMPHY_seq_write(mp, addr, data);
-
-   exit_critical(); // UNLOCK
+      exit_critical(mp); // UNLOCK
+   }
 
    return 0;
 }
@@ -168,12 +169,12 @@ int MEMPHY_format(struct memphy_struct *mp, int pagesz)
 
 int MEMPHY_get_freefp(struct memphy_struct *mp, addr_t *retfpn)
 {
-   enter_critical(); // LOCK
+   enter_critical(mp); // LOCK
 
    struct framephy_struct *fp = mp->free_fp_list;
 
    if (fp == NULL) {
-      exit_critical(); 
+      exit_critical(mp); 
       return -1;
    }
 
@@ -181,7 +182,7 @@ int MEMPHY_get_freefp(struct memphy_struct *mp, addr_t *retfpn)
    mp->free_fp_list = fp->fp_next;
    free(fp);
 
-   exit_critical(); // UNLOCK
+   exit_critical(mp); // UNLOCK
    return 0;
 }
 
@@ -197,7 +198,7 @@ int MEMPHY_dump(struct memphy_struct *mp)
 
 int MEMPHY_put_freefp(struct memphy_struct *mp, addr_t fpn)
 {
-   enter_critical(); // LOCK
+   enter_critical(mp); // LOCK
 
    struct framephy_struct *fp = mp->free_fp_list;
    struct framephy_struct *newnode = malloc(sizeof(struct framephy_struct));
@@ -206,7 +207,7 @@ int MEMPHY_put_freefp(struct memphy_struct *mp, addr_t fpn)
    newnode->fp_next = fp;
    mp->free_fp_list = newnode;
 
-   exit_critical(); // UNLOCK
+   exit_critical(mp); // UNLOCK
    return 0;
 }
 
@@ -217,6 +218,7 @@ int init_memphy(struct memphy_struct *mp, addr_t max_size, int randomflg)
 {
    mp->storage = (BYTE *)malloc(max_size * sizeof(BYTE));
    mp->maxsz = max_size;
+   mp->lock = 0;
    memset(mp->storage, 0, max_size * sizeof(BYTE));
 
    MEMPHY_format(mp, PAGING_PAGESZ);
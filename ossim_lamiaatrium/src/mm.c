@@ -9,6 +9,7 @@
  */
  
 #include "mm.h"
+#include <pthread.h>
 #include <stdlib.h>
 #include <stdio.h>
 
@@ -247,6 +248,7 @@ int init_mm(struct mm_struct *mm, struct pcb_t *caller)
   vma->vm_mm = mm; /* Gán ngược lại pointer mm */
   mm->mmap = vma;
   mm->fifo_pgn = NULL; 
+  pthread_mutex_init(&mm->lock, NULL);
 
   return 0;
 }
@@ -14,6 +14,8 @@
  */
 
 #include "mm64.h"
+#include "libmem.h"
+#include <pthread.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
@@ -32,6 +34,7 @@ void print_paging_stats() {
     printf("============================================================\n");
     printf("  [+] Page Table Storage Size : %lu bytes\n", total_pgtbl_size);
     printf("  [+] Memory Access Count     : %lu times\n", memory_access_count);
+    printf("  [+] Page Fault Count        : %lu times\n", nr_page_faults());
     printf("============================================================\n\n");
 }
 static addr_t *__get_pte(struct mm_struct *mm, addr_t pgn, int alloc) {
@@ -262,12 +265,11 @@ int __swap_cp_page(struct memphy_struct *mpsrc, addr_t srcfpn,
 {
   int cellidx;
   addr_t addrsrc, addrdst;
-  // [FIX] Use PAGING64_PAGESZ to copy full 4KB page
-  for(cellidx = 0; cellidx < PAGING64_PAGESZ; cellidx++)
+  /* Frames are PAGING_PAGESZ, the size MEMPHY_format() cut them to */
+  for(cellidx = 0; cellidx < PAGING_PAGESZ; cellidx++)
   {
-    // [FIX] Use PAGING64_PAGESZ for address calculation
-    addrsrc = srcfpn * PAGING64_PAGESZ + cellidx;
-    addrdst = dstfpn * PAGING64_PAGESZ + cellidx;
+    addrsrc = srcfpn * PAGING_PAGESZ + cellidx;
+    addrdst = dstfpn * PAGING_PAGESZ + cellidx;
 
     BYTE data;
     MEMPHY_read(mpsrc, addrsrc, &data);
@@ -290,6 +292,8 @@ int init_mm(struct mm_struct *mm, struct pcb_t *caller)
     mm->pud = NULL; 
     mm->pmd = NULL; 
     mm->pt = NULL;
+    mm->fifo_pgn = NULL;
+    pthread_mutex_init(&mm->lock, NULL);
 
     vma->vm_id = 0;
     vma->vm_start = 0;
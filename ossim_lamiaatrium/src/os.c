@@ -9,10 +9,15 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <unistd.h>
 
 static int time_slot;
 static int num_cpus;
 static int done = 0;
+/* Earliest time slot the loader may add a process in */
+static uint64_t next_arrival = 0;
+/* Worker threads running the CPUs, 0 for one thread per CPU */
+static int nr_workers = 0;
 static struct krnl_t os;
 
 pthread_mutex_t mem_lock;
@@ -29,122 +34,389 @@ struct mmpaging_ld_args {
 	struct memphy_struct **mswp;
 	struct memphy_struct *active_mswp;
 	int active_mswp_id;
-	struct timer_id_t  *timer_id;
 };
 #endif
 
-static struct ld_args{
-	char ** path;
-	unsigned long * start_time;
-#ifdef MLQ_SCHED
-	unsigned long * prio;
-#endif
-} ld_processes;
+/*
+ * The process lines of the config file, read as the loader needs them.
+ * Up to ARRIVAL_WINDOW lines are read ahead into a min-heap by start
+ * time, ties in file order, so a file only has to be sorted to within
+ * that many lines and any size runs in constant memory.
+ */
+struct arrival {
+	unsigned long start_time;
+	unsigned long prio;	/* PRIO_DEFAULT: keep the program's own */
+	unsigned long deadline; /* relative to start_time, 0 for none */
+	unsigned long seq;	/* line number among the process lines */
+	char * path;
+};
+#define PRIO_DEFAULT ((unsigned long)-1)
+
+static struct {
+	FILE * file;
+	int left;		/* process lines not read yet */
+	unsigned long seq;
+	struct arrival heap[ARRIVAL_WINDOW];
+	int nr;
+} arrivals;
 int num_processes;
 
+/*
+ * A CPU does its work for one time slot in a step. A step returns the
+ * time slot the device next has work in, or DEVICE_STOPPED once it is
+ * done. The engine runs the steps and the clock between them.
+ */
+#define DEVICE_STOPPED 0
+
 struct cpu_args {
 	struct timer_id_t * timer_id;
 	int id;
+	int time_left;
+	struct pcb_t * proc;
+	uint64_t wake;		/* worker pool engine only */
+	int stopped;
 };
 
+static uint64_t cpu_step(struct cpu_args * cpu) {
+	int id = cpu->id;
+	/* Check the status of current process */
+	if (cpu->proc == NULL) {
+		/* No process is running, the we load new process from
+		 * ready queue */
+		cpu->proc = get_proc(id);
+	}else if (cpu->proc->pc >= cpu->proc->code->size) {
+		/* The porcess has finish it job */
+		printf("\tCPU %d: Processed %2d has finished\n",
+			id, cpu->proc->pid);
+		finish_proc(cpu->proc);
+		put_code(cpu->proc->code);
+		free(cpu->proc);
+		cpu->proc = get_proc(id);
+		cpu->time_left = 0;
+	}else if (cpu->proc->sleep_until) {
+		/* It made the sleep system call */
+		printf("\tCPU %d: Process %2d sleeps until time slot %llu\n",
+			id, cpu->proc->pid,
+			(unsigned long long)cpu->proc->sleep_until);
+		sleep_proc(cpu->proc);
+		cpu->proc = get_proc(id);
+		cpu->time_left = 0;
+	}else if (cpu->time_left == 0 || need_resched(id)) {
+		/* The process has done its job in current time slot,
+		 * or a more urgent one arrived for this CPU */
+		printf("\tCPU %d: Put process %2d to run queue\n",
+			id, cpu->proc->pid);
+		put_proc(cpu->proc);
+		cpu->proc = get_proc(id);
+		cpu->time_left = 0;
+	}
+
+	/* Recheck process status after loading new process */
+	if (cpu->proc == NULL && done && queue_empty() && !proc_asleep()) {
+		/* No process to run, exit */
+		printf("\tCPU %d stopped\n", id);
+		return DEVICE_STOPPED;
+	}else if (cpu->proc == NULL) {
+		/* There may be new processes to run in
+		 * next time slots, just skip current slot.
+		 * Only the loader can bring one to an empty
+		 * system, so leave the pace to it */
+		return queue_empty() ? TIMER_NEVER : current_time() + 1;
+	}else if (cpu->time_left == 0) {
+		printf("\tCPU %d: Dispatched process %2d\n",
+			id, cpu->proc->pid);
+		cpu->time_left = get_quantum(cpu->proc, time_slot);
+	}
+
+	/* Run current process. A run of CALC goes in one step, as long
+	 * as no arrival may preempt it in between */
+	uint64_t now = current_time();
+	uint64_t arrival = __atomic_load_n(&next_arrival, __ATOMIC_RELAXED);
+	int batch = (cpu->time_left < CPU_BATCH) ? cpu->time_left : CPU_BATCH;
+	int n;
+
+	if (arrival <= now)
+		batch = 1;
+	else if (arrival - now < batch)
+		batch = arrival - now;
+	n = run_batch(cpu->proc, batch);
+	if (n == 0) {
+		run(cpu->proc);
+		n = 1;
+	}
+	cpu->time_left -= n;
+	return now + n;
+}
+
 static void * cpu_routine(void * args) {
-	struct timer_id_t * timer_id = ((struct cpu_args*)args)->timer_id;
-	int id = ((struct cpu_args*)args)->id;
-	/* Check for new process in ready queue */
-	int time_left = 0;
-	struct pcb_t * proc = NULL;
-	while (1) {
-		/* Check the status of current process */
-		if (proc == NULL) {
-			/* No process is running, the we load new process from
-		 	* ready queue */
-			proc = get_proc();
-			if (proc == NULL) {
-                           next_slot(timer_id);
-                           continue; /* First load failed. skip dummy load */
-                        }
-		}else if (proc->pc == proc->code->size) {
-			/* The porcess has finish it job */
-			printf("\tCPU %d: Processed %2d has finished\n",
-				id ,proc->pid);
-			purgequeue(proc->krnl->running_list, proc);
-			free(proc);
-			proc = get_proc();
-			time_left = 0;
-		}else if (time_left == 0) {
-			/* The process has done its job in current time slot */
-			printf("\tCPU %d: Put process %2d to run queue\n",
-				id, proc->pid);
-			put_proc(proc);
-			proc = get_proc();
+	struct cpu_args * cpu = (struct cpu_args*)args;
+	uint64_t wake;
+
+	while ((wake = cpu_step(cpu)) != DEVICE_STOPPED)
+		next_slot_at(cpu->timer_id, wake);
+	detach_event(cpu->timer_id);
+	pthread_exit(NULL);
+}
+
+#define arrival_before(a, b) ((a)->start_time < (b)->start_time || \
+	((a)->start_time == (b)->start_time && (a)->seq < (b)->seq))
+
+static void arrival_swap(int a, int b) {
+	struct arrival tmp = arrivals.heap[a];
+	arrivals.heap[a] = arrivals.heap[b];
+	arrivals.heap[b] = tmp;
+}
+
+/*
+ * Read the next process line: start_time path [prio [relative
+ * deadline]]. Blank lines are skipped. Return 0 at the end of the file.
+ */
+static int read_arrival(struct arrival * a) {
+	char * line = NULL, * name, * end;
+	size_t cap = 0;
+	int len;
+
+	do {
+		if (getline(&line, &cap, arrivals.file) < 0) {
+			free(line);
+			return 0;
 		}
-		
-		/* Recheck process status after loading new process */
-		if (proc == NULL && done) {
-			/* No process to run, exit */
-			printf("\tCPU %d stopped\n", id);
+	} while (line[strspn(line, " \t\r\n")] == '\0');
+
+	a->start_time = strtoul(line, &name, 10);
+	name += strspn(name, " \t");
+	len = strcspn(name, " \t\r\n");
+	a->prio = PRIO_DEFAULT;
+	a->deadline = 0;
+	a->seq = arrivals.seq++;
+	end = name + len;
+	if (*end != '\0') {
+		char * p = end + 1;
+
+		a->prio = strtoul(p, &end, 10);
+		if (end == p)
+			a->prio = PRIO_DEFAULT;
+		else
+			a->deadline = strtoul(end, NULL, 10);
+	}
+	a->path = (char*)malloc(strlen("input/proc/") + len + 1);
+	sprintf(a->path, "input/proc/%.*s", len, name);
+	free(line);
+	return 1;
+}
+
+/* Take the next process to arrive, 0 when there is none left */
+static int next_process(struct arrival * a) {
+	int i, child, parent;
+
+	/* Top up the window */
+	while (arrivals.nr < ARRIVAL_WINDOW && arrivals.left > 0) {
+		i = arrivals.nr;
+		if (!read_arrival(&arrivals.heap[i])) {
+			/* Fewer lines than the header says */
+			arrivals.left = 0;
 			break;
-		}else if (proc == NULL) {
-			/* There may be new processes to run in
-			 * next time slots, just skip current slot */
-			next_slot(timer_id);
-			continue;
-		}else if (time_left == 0) {
-			printf("\tCPU %d: Dispatched process %2d\n",
-				id, proc->pid);
-			time_left = time_slot;
 		}
-		
-		/* Run current process */
-		run(proc);
-		time_left--;
-		next_slot(timer_id);
+		arrivals.nr++;
+		arrivals.left--;
+		while (i > 0) {
+			parent = (i - 1) / 2;
+			if (!arrival_before(&arrivals.heap[i],
+					&arrivals.heap[parent]))
+				break;
+			arrival_swap(i, parent);
+			i = parent;
+		}
 	}
-	detach_event(timer_id);
-	pthread_exit(NULL);
+	if (arrivals.left == 0 && arrivals.file != NULL) {
+		fclose(arrivals.file);
+		arrivals.file = NULL;
+	}
+	if (arrivals.nr == 0)
+		return 0;
+
+	*a = arrivals.heap[0];
+	arrivals.heap[0] = arrivals.heap[--arrivals.nr];
+	i = 0;
+	while ((child = 2 * i + 1) < arrivals.nr) {
+		if (child + 1 < arrivals.nr &&
+		    arrival_before(&arrivals.heap[child + 1],
+				&arrivals.heap[child]))
+			child++;
+		if (!arrival_before(&arrivals.heap[child], &arrivals.heap[i]))
+			break;
+		arrival_swap(i, child);
+		i = child;
+	}
+	return 1;
 }
 
-static void * ld_routine(void * args) {
+/*
+ * The loader. Process i arrives at its start time, but not before the
+ * time slot after the one process i - 1 arrived in. A prefetch thread
+ * takes the processes from the config file in arrival order and loads
+ * them, with their mm_struct, up to LOADER_PREFETCH of them ahead of
+ * the arrivals. Each arrival is a timer event, which takes its process
+ * from the prefetched ones, adds it and sets up the next arrival.
+ */
+static struct {
+	struct wheel_timer event;
+	int next;		/* index of the next process to arrive */
+	int nr_loaded;		/* processes the prefetch thread loaded */
+	int eof;		/* it has loaded them all */
+	struct {
+		struct pcb_t * proc;
+		struct arrival arrival;
+	} ready[LOADER_PREFETCH];
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	pthread_t prefetch;
 #ifdef MM_PAGING
-	struct memphy_struct* mram = ((struct mmpaging_ld_args *)args)->mram;
-	struct memphy_struct** mswp = ((struct mmpaging_ld_args *)args)->mswp;
-	struct memphy_struct* active_mswp = ((struct mmpaging_ld_args *)args)->active_mswp;
-	struct timer_id_t * timer_id = ((struct mmpaging_ld_args *)args)->timer_id;
-#else
-	struct timer_id_t * timer_id = (struct timer_id_t*)args;
+	struct mmpaging_ld_args * mm;
 #endif
-	int i = 0;
-	printf("ld_routine\n");
-	while (i < num_processes) {
-		struct pcb_t * proc = load(ld_processes.path[i]);
-		struct krnl_t * krnl = proc->krnl = &os;	
-
-#ifdef MLQ_SCHED
-		proc->prio = ld_processes.prio[i];
-#endif
-		while (current_time() < ld_processes.start_time[i]) {
-			next_slot(timer_id);
-		}
+} loader = {
+	.lock = PTHREAD_MUTEX_INITIALIZER,
+	.cond = PTHREAD_COND_INITIALIZER,
+};
+
+static void * prefetch_routine(void * args) {
+	struct arrival a;
+	struct pcb_t * proc;
+	int i;
+
+	for (i = 0; ; i++) {
+		pthread_mutex_lock(&loader.lock);
+		while (i - loader.next >= LOADER_PREFETCH)
+			pthread_cond_wait(&loader.cond, &loader.lock);
+		pthread_mutex_unlock(&loader.lock);
+
+		if (!next_process(&a))
+			break;
+		proc = load(a.path);
+		proc->krnl = &os;
+		if (a.prio == PRIO_DEFAULT)
+			a.prio = proc->priority;
+		/* The policies index by prio, clamp what the config or
+		 * the program asks for to the lowest priority */
+		proc->prio = (a.prio < MAX_PRIO) ? a.prio : MAX_PRIO - 1;
+		proc->deadline = a.deadline ? a.start_time + a.deadline : 0;
 #ifdef MM_PAGING
 		proc->mm = malloc(sizeof(struct mm_struct));
-        init_mm(proc->mm, proc);
-        
-		krnl->mram = mram;
-		krnl->mswp = mswp;
-		krnl->active_mswp = active_mswp;
+		init_mm(proc->mm, proc);
 #endif
-		printf("\tLoaded a process at %s, PID: %d PRIO: %ld\n",
-			ld_processes.path[i], proc->pid, ld_processes.prio[i]);
-		add_proc(proc);
-		free(ld_processes.path[i]);
-		i++;
-		next_slot(timer_id);
+
+		pthread_mutex_lock(&loader.lock);
+		loader.ready[i % LOADER_PREFETCH].proc = proc;
+		loader.ready[i % LOADER_PREFETCH].arrival = a;
+		loader.nr_loaded = i + 1;
+		pthread_cond_broadcast(&loader.cond);
+		pthread_mutex_unlock(&loader.lock);
 	}
-	free(ld_processes.path);
-	free(ld_processes.start_time);
-	done = 1;
-	detach_event(timer_id);
-	pthread_exit(NULL);
+
+	pthread_mutex_lock(&loader.lock);
+	loader.eof = 1;
+	pthread_cond_broadcast(&loader.cond);
+	pthread_mutex_unlock(&loader.lock);
+	return NULL;
+}
+
+static void schedule_arrival(uint64_t now) {
+	int i = loader.next;
+	unsigned long start;
+	int last;
+
+	/* Only waits when the prefetch thread fell behind */
+	pthread_mutex_lock(&loader.lock);
+	while (loader.nr_loaded <= i && !loader.eof)
+		pthread_cond_wait(&loader.cond, &loader.lock);
+	last = (loader.nr_loaded <= i);
+	pthread_mutex_unlock(&loader.lock);
+
+	if (last) {
+		__atomic_store_n(&next_arrival, TIMER_NEVER, __ATOMIC_RELAXED);
+		pthread_join(loader.prefetch, NULL);
+		done = 1;
+		return;
+	}
+	start = loader.ready[i % LOADER_PREFETCH].arrival.start_time;
+	loader.event.expires = (start > now) ? start : now;
+	__atomic_store_n(&next_arrival, loader.event.expires,
+			__ATOMIC_RELAXED);
+	timer_add(&loader.event);
+}
+
+static void arrive(struct wheel_timer * event) {
+	int i = loader.next;
+	struct pcb_t * proc = loader.ready[i % LOADER_PREFETCH].proc;
+	char * path = loader.ready[i % LOADER_PREFETCH].arrival.path;
+
+#ifdef MM_PAGING
+	struct krnl_t * krnl = proc->krnl;
+
+	krnl->mram = loader.mm->mram;
+	krnl->mswp = loader.mm->mswp;
+	krnl->active_mswp = loader.mm->active_mswp;
+#endif
+	printf("\tLoaded a process at %s, PID: %d PRIO: %u\n",
+		path, proc->pid, proc->prio);
+	add_proc(proc);
+	free(path);
+
+	/* Hand the slot back to the prefetch thread */
+	pthread_mutex_lock(&loader.lock);
+	loader.next++;
+	pthread_cond_broadcast(&loader.cond);
+	pthread_mutex_unlock(&loader.lock);
+	schedule_arrival(current_time() + 1);
+}
+
+/*
+ * Worker pool engine: a fixed number of worker threads share the CPUs
+ * round robin. In each time slot a worker steps its CPUs that are
+ * awake in id order, and the workers meet at the time slot barrier.
+ * Any run is one interleaving of the threaded engine; with a single
+ * worker it is the same on every run.
+ */
+struct worker_args {
+	struct timer_id_t * timer_id;
+	struct cpu_args * cpus;
+	int id;
+};
+
+static void * worker_routine(void * args) {
+	struct worker_args * w = (struct worker_args*)args;
+	int i;
+
+	while (1) {
+		uint64_t now = current_time(), next = TIMER_NEVER;
+		int running = 0, idle = 0;
+
+		for (i = w->id; i < num_cpus; i += nr_workers) {
+			struct cpu_args * cpu = &w->cpus[i];
+
+			if (cpu->stopped)
+				continue;
+			if (cpu->wake == TIMER_NEVER || cpu->wake <= now)
+				cpu->wake = cpu_step(cpu);
+			if (cpu->wake == DEVICE_STOPPED) {
+				cpu->stopped = 1;
+			} else {
+				running = 1;
+				idle |= (cpu->wake == TIMER_NEVER);
+				if (cpu->wake < next)
+					next = cpu->wake;
+			}
+		}
+		if (!running)
+			break;
+		/* An idle CPU may find work at any time slot */
+		if (idle)
+			next_slot_idle(w->timer_id, next);
+		else
+			next_slot_at(w->timer_id, next);
+	}
+	detach_event(w->timer_id);
+	return NULL;
 }
 
 static void read_config(const char * path) {
@@ -154,9 +426,6 @@ static void read_config(const char * path) {
 		exit(1);
 	}
 	fscanf(file, "%d %d %d\n", &time_slot, &num_cpus, &num_processes);
-	ld_processes.path = (char**)malloc(sizeof(char*) * num_processes);
-	ld_processes.start_time = (unsigned long*)
-		malloc(sizeof(unsigned long) * num_processes);
 #ifdef MM_PAGING
 	int sit;
 #ifdef MM_FIXED_MEMSZ
@@ -175,55 +444,77 @@ static void read_config(const char * path) {
 #endif
 #endif
 
-#ifdef MLQ_SCHED
-	ld_processes.prio = (unsigned long*)
-		malloc(sizeof(unsigned long) * num_processes);
-#endif
-	int i;
-	for (i = 0; i < num_processes; i++) {
-		ld_processes.path[i] = (char*)malloc(sizeof(char) * 100);
-		ld_processes.path[i][0] = '\0';
-		strcat(ld_processes.path[i], "input/proc/");
-		char proc[100] = "";
-#ifdef MLQ_SCHED
-		fscanf(file, "%lu %s %lu\n", &ld_processes.start_time[i], proc, &ld_processes.prio[i]);
-#else
-		fscanf(file, "%lu %s\n", &ld_processes.start_time[i], proc);
-#endif
-	int len = strlen(proc);
-	while (len > 0 && (proc[len - 1] == '\r' || proc[len - 1] == '\n')) {
-		proc[len - 1] = '\0';
-		len--;
-	}
-		strcat(ld_processes.path[i], proc);
-	}
+	arrivals.file = file;
+	arrivals.left = num_processes;
+}
+
+static void usage(void) {
+	const char * const * name;
+
+	printf("Usage: os [-s policy] [-e engine] [path to configure file]\n");
+	printf("Policies:");
+	for (name = sched_policy_names(); *name; name++)
+		printf(" %s", *name);
+	printf(" (default %s)\n", SCHED_POLICY);
+	printf("Engines: threads single pool (default %s)\n", SIM_ENGINE);
+}
+
+/* Select the simulation engine by name, -1 if unknown */
+static int set_engine(const char * name) {
+	if (strcmp(name, "threads") == 0)
+		nr_workers = 0;
+	else if (strcmp(name, "single") == 0)
+		nr_workers = 1;
+	else if (strcmp(name, "pool") == 0)
+		nr_workers = sysconf(_SC_NPROCESSORS_ONLN);
+	else
+		return -1;
+	return 0;
 }
 
 int main(int argc, char * argv[]) {
-	/* Read config */
-	if (argc != 2) {
-		printf("Usage: os [path to configure file]\n");
+	/* Read options and config */
+	int opt;
+	set_sched_policy(SCHED_POLICY);
+	set_engine(SIM_ENGINE);
+	while ((opt = getopt(argc, argv, "s:e:")) != -1) {
+		if ((opt == 's' && set_sched_policy(optarg) == 0) ||
+		    (opt == 'e' && set_engine(optarg) == 0))
+			continue;
+		usage();
 		return 1;
 	}
-	char path[100];
-	path[0] = '\0';
-	strcat(path, "input/");
-	strcat(path, argv[1]);
+	if (optind != argc - 1) {
+		usage();
+		return 1;
+	}
+	char * path = (char*)malloc(strlen("input/") + strlen(argv[optind]) + 1);
+	sprintf(path, "input/%s", argv[optind]);
 	read_config(path);
+	free(path);
+
+	/* No worker without a CPU */
+	if (nr_workers > num_cpus)
+		nr_workers = num_cpus;
 
 	pthread_t * cpu = (pthread_t*)malloc(num_cpus * sizeof(pthread_t));
 	struct cpu_args * args =
-		(struct cpu_args*)malloc(sizeof(struct cpu_args) * num_cpus);
-	pthread_t ld;
+		(struct cpu_args*)calloc(num_cpus, sizeof(struct cpu_args));
+	struct worker_args * workers =
+		(struct worker_args*)calloc(nr_workers, sizeof(struct worker_args));
+	pthread_t * worker = (pthread_t*)malloc(nr_workers * sizeof(pthread_t));
 	
-	/* Init timer */
+	/* Init timer, one event per thread meeting at the time slots */
 	int i;
 	for (i = 0; i < num_cpus; i++) {
-		args[i].timer_id = attach_event();
+		args[i].timer_id = nr_workers ? NULL : attach_event();
 		args[i].id = i;
 	}
-	struct timer_id_t * ld_event = attach_event();
-	start_timer();
+	for (i = 0; i < nr_workers; i++) {
+		workers[i].timer_id = attach_event();
+		workers[i].cpus = args;
+		workers[i].id = i;
+	}
 
     pthread_mutex_init(&mem_lock, NULL);
 
@@ -245,7 +536,6 @@ int main(int argc, char * argv[]) {
 	/* In Paging mode, it needs passing the system mem to each PCB through loader*/
 	struct mmpaging_ld_args *mm_ld_args = malloc(sizeof(struct mmpaging_ld_args));
 
-	mm_ld_args->timer_id = ld_event;
 	mm_ld_args->mram = (struct memphy_struct *) &mram;
 	mm_ld_args->mswp = (struct memphy_struct**) &mswp;
 	mm_ld_args->active_mswp = (struct memphy_struct *) &mswp[0];
@@ -253,28 +543,45 @@ int main(int argc, char * argv[]) {
 #endif
 
 	/* Init scheduler */
-	init_scheduler();
+	init_scheduler(num_cpus);
 
-	/* Run CPU and loader */
+	/* The loader brings the processes in on timer events */
 #ifdef MM_PAGING
-	pthread_create(&ld, NULL, ld_routine, (void*)mm_ld_args);
-#else
-	pthread_create(&ld, NULL, ld_routine, (void*)ld_event);
+	loader.mm = mm_ld_args;
 #endif
-	for (i = 0; i < num_cpus; i++) {
-		pthread_create(&cpu[i], NULL,
-			cpu_routine, (void*)&args[i]);
-	}
+	loader.event.fn = arrive;
+	pthread_create(&loader.prefetch, NULL, prefetch_routine, NULL);
+	schedule_arrival(0);
+	start_timer();
 
-	/* Wait for CPU and loader finishing */
-	for (i = 0; i < num_cpus; i++) {
-		pthread_join(cpu[i], NULL);
+	/* Run CPU */
+	if (nr_workers == 1) {
+		/* No need for another thread */
+		worker_routine(&workers[0]);
+	} else if (nr_workers > 1) {
+		for (i = 0; i < nr_workers; i++) {
+			pthread_create(&worker[i], NULL,
+				worker_routine, (void*)&workers[i]);
+		}
+		for (i = 0; i < nr_workers; i++) {
+			pthread_join(worker[i], NULL);
+		}
+	} else {
+		for (i = 0; i < num_cpus; i++) {
+			pthread_create(&cpu[i], NULL,
+				cpu_routine, (void*)&args[i]);
+		}
+
+		/* Wait for CPU finishing */
+		for (i = 0; i < num_cpus; i++) {
+			pthread_join(cpu[i], NULL);
+		}
 	}
-	pthread_join(ld, NULL);
 
 	/* Stop timer */
 	stop_timer();
 	print_paging_stats();
+	print_sched_stats();
 
 	return 0;
 }
\ No newline at end of file
@@ -2,6 +2,13 @@
 #include <stdlib.h>
 #include "queue.h"
 
+/*
+ * A purged process leaves a NULL hole in its slot instead of shifting
+ * the ring. Holes at either end are trimmed right away, the ones in
+ * the middle are skipped by dequeue. tail - head counts the holes too.
+ */
+#define slot(q, pos) ((q)->proc[(pos) & ((q)->cap - 1)])
+
 int empty(struct queue_t *q)
 {
         if (q == NULL)
@@ -9,21 +16,69 @@ int empty(struct queue_t *q)
         return (q->size == 0);
 }
 
+/* Make room for one more slot: squeeze the holes out when they take
+ * half of the ring, double it otherwise. Positions are kept on growth */
+static int grow(struct queue_t *q)
+{
+        unsigned long pos;
+
+        if (q->cap > 0 && q->size <= q->cap / 2) {
+                unsigned long to = q->head;
+                for (pos = q->head; pos != q->tail; pos++) {
+                        struct pcb_t *p = slot(q, pos);
+                        slot(q, pos) = NULL;
+                        if (p != NULL) {
+                                slot(q, to) = p;
+                                p->qpos = to++;
+                        }
+                }
+                q->tail = to;
+                return 0;
+        }
+
+        int cap = q->cap ? q->cap * 2 : MAX_QUEUE_SIZE;
+        while (cap & (cap - 1))         /* round up to a power of two */
+                cap += cap & -cap;
+        struct pcb_t **proc = calloc(cap, sizeof(struct pcb_t *));
+        if (proc == NULL)
+                return -1;
+        for (pos = q->head; pos != q->tail; pos++)
+                proc[pos & (cap - 1)] = slot(q, pos);
+        free(q->proc);
+        q->proc = proc;
+        q->cap = cap;
+        return 0;
+}
+
 void enqueue(struct queue_t *q, struct pcb_t *proc)
 {
     if (!q || !proc) return;
 
-    if (q->size >= MAX_QUEUE_SIZE) {
+    if (q->tail - q->head >= (unsigned long)q->cap && grow(q) < 0) {
         printf("Queue limit exceeded!\n");
         return;
     }
 
     //update assign proc, update tail and size
-    q->proc[q->tail] = proc;
-    q->tail = (q->tail + 1) % MAX_QUEUE_SIZE;
+    slot(q, q->tail) = proc;
+    proc->qpos = q->tail;
+    q->tail++;
     q->size++;
 }
 
+/* Drop the holes left at the head and at the tail by purgequeue */
+static void trim(struct queue_t *q)
+{
+        if (q->size == 0) {
+                q->head = q->tail;
+                return;
+        }
+        while (slot(q, q->head) == NULL)
+                q->head++;
+        while (slot(q, q->tail - 1) == NULL)
+                q->tail--;
+}
+
 struct pcb_t *dequeue(struct queue_t *q)
 {
         /* TODO: return a pcb whose priority is the highest
@@ -31,13 +86,14 @@ struct pcb_t *dequeue(struct queue_t *q)
          * */
         if (!q || q->size == 0) return NULL;
 
-        //extract process and clear
-        struct pcb_t *p_out = q->proc[q->head]; 
-        q->proc[q->head] = NULL; 
+        //extract process and clear, head never rests on a hole
+        struct pcb_t *p_out = slot(q, q->head);
+        slot(q, q->head) = NULL;
 
         //update head and size
-        q->head = (q->head + 1) % MAX_QUEUE_SIZE;
+        q->head++;
         q->size --;
+        trim(q);
 
         return p_out;
 }
@@ -49,34 +105,110 @@ struct pcb_t *purgequeue(struct queue_t *q, struct pcb_t *proc)
 
         if(!q || !proc ||q->size == 0) return NULL;
 
-        // iterate through the queue, take the desired proccess
-        int curr = q->head;
-        int proc_idx = -1;
-        for (int i = 0; i < q->size; i++)
-        {
-                if(q->proc[curr] == proc)
-                {
-                        proc_idx = curr;
-                        break;
-                }
-                curr = (curr + 1) % MAX_QUEUE_SIZE;
+        // the process remembers its position, no search needed
+        unsigned long pos = proc->qpos;
+        if (pos - q->head >= q->tail - q->head || slot(q, pos) != proc)
+                return NULL;
+
+        // leave a hole, update size
+        slot(q, pos) = NULL;
+        q->size --;
+        trim(q);
+        return proc;
+}
+
+struct pcb_t *queue_find(struct queue_t *q, uint32_t pid)
+{
+        unsigned long pos;
+
+        if (!q || q->size == 0) return NULL;
+
+        for (pos = q->head; pos != q->tail; pos++)
+                if (slot(q, pos) && slot(q, pos)->pid == pid)
+                        return slot(q, pos);
+        return NULL;
+}
+
+#ifdef QUEUE_LOCKFREE
+#define LFQUEUE_MASK (LFQUEUE_CAPACITY - 1)
 
+/* Sequence number of cell i, stored relative to i so zero means "free" */
+#define seq_load(q, i) \
+        (__atomic_load_n(&(q)->seq[i], __ATOMIC_ACQUIRE) + (i))
+#define seq_store(q, i, v) \
+        __atomic_store_n(&(q)->seq[i], (v) - (i), __ATOMIC_RELEASE)
+
+int lfq_empty(struct lfqueue_t *q)
+{
+        if (q == NULL)
+                return 1;
+        return (__atomic_load_n(&q->size, __ATOMIC_ACQUIRE) <= 0);
+}
+
+int lfq_enqueue(struct lfqueue_t *q, struct pcb_t *proc)
+{
+        if (!q || !proc) return -1;
+
+        unsigned long pos = __atomic_load_n(&q->tail, __ATOMIC_RELAXED);
+        unsigned long i;
+
+        for (;;) {
+                i = pos & LFQUEUE_MASK;
+                long dif = (long)(seq_load(q, i) - pos);
+
+                if (dif == 0) {
+                        /* Cell is free at this lap, try to claim it */
+                        if (__atomic_compare_exchange_n(&q->tail, &pos, pos + 1,
+                                        1, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+                                break;
+                } else if (dif < 0) {
+                        /* Full, unless a dequeuer of the last lap still
+                         * holds the cell: then head has moved on already.
+                         * pos may be stale by now, head can be past it */
+                        long used = (long)(pos -
+                                __atomic_load_n(&q->head, __ATOMIC_ACQUIRE));
+                        if (used >= LFQUEUE_CAPACITY)
+                                return -1;
+                        pos = __atomic_load_n(&q->tail, __ATOMIC_RELAXED);
+                } else {
+                        pos = __atomic_load_n(&q->tail, __ATOMIC_RELAXED);
+                }
         }
-        // if there is no match
-        if(proc_idx == -1) return NULL;
-
-        //shift elements to the left
-        int next = (curr + 1) % MAX_QUEUE_SIZE;
-        while(next != q->tail)
-        {
-                q->proc[curr] = q->proc[next];
-                curr = next;
-                next = (next + 1) % MAX_QUEUE_SIZE;
+
+        q->proc[i] = proc;
+        seq_store(q, i, pos + 1);
+        __atomic_fetch_add(&q->size, 1, __ATOMIC_RELEASE);
+        return 0;
+}
+
+struct pcb_t *lfq_dequeue(struct lfqueue_t *q)
+{
+        if (!q) return NULL;
+
+        unsigned long pos = __atomic_load_n(&q->head, __ATOMIC_RELAXED);
+        unsigned long i;
+
+        for (;;) {
+                i = pos & LFQUEUE_MASK;
+                long dif = (long)(seq_load(q, i) - (pos + 1));
+
+                if (dif == 0) {
+                        /* Cell was published at this lap, try to take it */
+                        if (__atomic_compare_exchange_n(&q->head, &pos, pos + 1,
+                                        1, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+                                break;
+                } else if (dif < 0) {
+                        return NULL;
+                } else {
+                        pos = __atomic_load_n(&q->head, __ATOMIC_RELAXED);
+                }
         }
 
-        // update tail, size
-        q->proc[q->tail] = NULL;
-        q->tail = (q->tail - 1 + MAX_QUEUE_SIZE) % MAX_QUEUE_SIZE;
-        q->size --;
-        return proc;
-}
\ No newline at end of file
+        struct pcb_t *p_out = q->proc[i];
+        q->proc[i] = NULL;
+        seq_store(q, i, pos + LFQUEUE_CAPACITY);
+        __atomic_fetch_sub(&q->size, 1, __ATOMIC_RELEASE);
+
+        return p_out;
+}
+#endif
@@ -0,0 +1,204 @@
+/*
+ * Red-black tree with parent pointers, after CLRS chapter 13.
+ * A missing child is NULL and counts as black.
+ */
+
+#include "rbtree.h"
+
+#define is_red(n)	((n) != NULL && (n)->color == RB_RED)
+#define is_black(n)	(!is_red(n))
+
+/* Make [new] take the place of [old] under old's parent */
+static void replace_child(struct rb_node *old, struct rb_node *new,
+			  struct rb_root *root) {
+	struct rb_node *parent = old->parent;
+
+	if (parent == NULL)
+		root->node = new;
+	else if (parent->left == old)
+		parent->left = new;
+	else
+		parent->right = new;
+	if (new)
+		new->parent = parent;
+}
+
+static void rotate_left(struct rb_node *x, struct rb_root *root) {
+	struct rb_node *y = x->right;
+
+	x->right = y->left;
+	if (y->left)
+		y->left->parent = x;
+	replace_child(x, y, root);
+	y->left = x;
+	x->parent = y;
+}
+
+static void rotate_right(struct rb_node *x, struct rb_root *root) {
+	struct rb_node *y = x->left;
+
+	x->left = y->right;
+	if (y->right)
+		y->right->parent = x;
+	replace_child(x, y, root);
+	y->right = x;
+	x->parent = y;
+}
+
+void rb_insert_color(struct rb_node *node, struct rb_root *root) {
+	struct rb_node *parent, *gparent, *uncle;
+
+	while ((parent = node->parent) != NULL && parent->color == RB_RED) {
+		gparent = parent->parent;
+		if (parent == gparent->left) {
+			uncle = gparent->right;
+			if (is_red(uncle)) {
+				parent->color = uncle->color = RB_BLACK;
+				gparent->color = RB_RED;
+				node = gparent;
+				continue;
+			}
+			if (node == parent->right) {
+				rotate_left(parent, root);
+				node = parent;
+				parent = node->parent;
+			}
+			parent->color = RB_BLACK;
+			gparent->color = RB_RED;
+			rotate_right(gparent, root);
+		} else {
+			uncle = gparent->left;
+			if (is_red(uncle)) {
+				parent->color = uncle->color = RB_BLACK;
+				gparent->color = RB_RED;
+				node = gparent;
+				continue;
+			}
+			if (node == parent->left) {
+				rotate_right(parent, root);
+				node = parent;
+				parent = node->parent;
+			}
+			parent->color = RB_BLACK;
+			gparent->color = RB_RED;
+			rotate_left(gparent, root);
+		}
+	}
+	root->node->color = RB_BLACK;
+}
+
+/* Restore the black height after removing a black node above [node] */
+static void erase_color(struct rb_node *node, struct rb_node *parent,
+			struct rb_root *root) {
+	struct rb_node *sibling;
+
+	while (node != root->node && is_black(node)) {
+		if (node == parent->left) {
+			sibling = parent->right;
+			if (is_red(sibling)) {
+				sibling->color = RB_BLACK;
+				parent->color = RB_RED;
+				rotate_left(parent, root);
+				sibling = parent->right;
+			}
+			if (is_black(sibling->left) && is_black(sibling->right)) {
+				sibling->color = RB_RED;
+				node = parent;
+				parent = node->parent;
+				continue;
+			}
+			if (is_black(sibling->right)) {
+				sibling->left->color = RB_BLACK;
+				sibling->color = RB_RED;
+				rotate_right(sibling, root);
+				sibling = parent->right;
+			}
+			sibling->color = parent->color;
+			parent->color = RB_BLACK;
+			sibling->right->color = RB_BLACK;
+			rotate_left(parent, root);
+		} else {
+			sibling = parent->left;
+			if (is_red(sibling)) {
+				sibling->color = RB_BLACK;
+				parent->color = RB_RED;
+				rotate_right(parent, root);
+				sibling = parent->left;
+			}
+			if (is_black(sibling->left) && is_black(sibling->right)) {
+				sibling->color = RB_RED;
+				node = parent;
+				parent = node->parent;
+				continue;
+			}
+			if (is_black(sibling->left)) {
+				sibling->right->color = RB_BLACK;
+				sibling->color = RB_RED;
+				rotate_left(sibling, root);
+				sibling = parent->left;
+			}
+			sibling->color = parent->color;
+			parent->color = RB_BLACK;
+			sibling->left->color = RB_BLACK;
+			rotate_right(parent, root);
+		}
+		node = root->node;
+		break;
+	}
+	if (node)
+		node->color = RB_BLACK;
+}
+
+void rb_erase(struct rb_node *node, struct rb_root *root) {
+	struct rb_node *child, *parent;
+	int color;
+
+	if (node->left == NULL || node->right == NULL) {
+		child = node->left ? node->left : node->right;
+		parent = node->parent;
+		color = node->color;
+		replace_child(node, child, root);
+	} else {
+		/* Splice out the successor and put it where [node] was */
+		struct rb_node *succ = node->right;
+		while (succ->left)
+			succ = succ->left;
+
+		child = succ->right;
+		color = succ->color;
+		if (succ->parent == node) {
+			parent = succ;
+		} else {
+			parent = succ->parent;
+			replace_child(succ, child, root);
+			succ->right = node->right;
+			succ->right->parent = succ;
+		}
+		replace_child(node, succ, root);
+		succ->left = node->left;
+		succ->left->parent = succ;
+		succ->color = node->color;
+	}
+	if (color == RB_BLACK)
+		erase_color(child, parent, root);
+}
+
+struct rb_node *rb_first(struct rb_root *root) {
+	struct rb_node *n = root->node;
+
+	if (n == NULL)
+		return NULL;
+	while (n->left)
+		n = n->left;
+	return n;
+}
+
+struct rb_node *rb_last(struct rb_root *root) {
+	struct rb_node *n = root->node;
+
+	if (n == NULL)
+		return NULL;
+	while (n->right)
+		n = n->right;
+	return n;
+}
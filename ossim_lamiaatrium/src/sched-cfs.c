@@ -0,0 +1,93 @@
+/*
+ * CFS policy: a process is charged the time slots it ran divided by
+ * its weight, and the one with the least charged virtual run time runs
+ * next. prio 0..MAX_PRIO-1 maps onto the 40 Linux nice levels.
+ */
+
+#include "sched.h"
+
+#include <stdlib.h>
+
+#define CFS_NICE_0_LOAD 1024
+#define CFS_VRUNTIME_SHIFT 20	/* fixed point, one slot = 1 << 20 */
+
+static const int cfs_prio_to_weight[40] = {
+ /* -20 */     88761,     71755,     56483,     46273,     36291,
+ /* -15 */     29154,     23254,     18705,     14949,     11916,
+ /* -10 */      9548,      7620,      6100,      4904,      3906,
+ /*  -5 */      3121,      2501,      1991,      1586,      1277,
+ /*   0 */      1024,       820,       655,       526,       423,
+ /*   5 */       335,       272,       215,       172,       137,
+ /*  10 */       110,        87,        70,        56,        45,
+ /*  15 */        36,        29,        23,        18,        15,
+};
+
+struct cfs_rq {
+	struct rb_root tree;		/* ready processes by vruntime */
+	uint64_t min_vruntime;		/* never decreases */
+};
+
+static inline int cfs_weight(struct pcb_t *proc) {
+	return cfs_prio_to_weight[proc->prio * 40 / MAX_PRIO];
+}
+
+static void *init_cfs(void) {
+	return calloc(1, sizeof(struct cfs_rq));
+}
+
+/* Leftmost process: the one which got the least of its fair share */
+static struct pcb_t *get_cfs_proc(void *data) {
+	struct cfs_rq *rq = data;
+	struct pcb_t *proc = vtree_take(&rq->tree, rb_first(&rq->tree));
+
+	if (proc && proc->vruntime > rq->min_vruntime)
+		__atomic_store_n(&rq->min_vruntime, proc->vruntime,
+				__ATOMIC_RELAXED);
+	return proc;
+}
+
+/* Migration candidate for rebalancing: the most served process */
+static struct pcb_t *pull_cfs_proc(void *data) {
+	struct cfs_rq *rq = data;
+	return vtree_take(&rq->tree, rb_last(&rq->tree));
+}
+
+static void put_cfs_proc(void *data, struct pcb_t *proc) {
+	struct cfs_rq *rq = data;
+
+	/* Newcomers start at the queue's pace rather than from 0 */
+	if (proc->vruntime < rq->min_vruntime)
+		proc->vruntime = rq->min_vruntime;
+	vtree_insert(&rq->tree, proc);
+}
+
+static void tick_cfs(struct pcb_t *proc, uint64_t slots) {
+	proc->vruntime += (slots << CFS_VRUNTIME_SHIFT)
+			* CFS_NICE_0_LOAD / cfs_weight(proc);
+}
+
+/* Carry a process's lead or lag over to another queue's time base */
+static void migrate_cfs(struct pcb_t *proc, void *from, void *to) {
+	proc->vruntime += __atomic_load_n(&((struct cfs_rq *)to)->min_vruntime,
+			__ATOMIC_RELAXED);
+	proc->vruntime -= __atomic_load_n(&((struct cfs_rq *)from)->min_vruntime,
+			__ATOMIC_RELAXED);
+}
+
+static struct pcb_t *find_cfs_proc(void *data, uint32_t pid) {
+	struct cfs_rq *rq = data;
+	return vtree_find(&rq->tree, pid);
+}
+
+const struct sched_ops cfs_sched_ops = {
+	.name	 = "cfs",
+	.init	 = init_cfs,
+	.add	 = put_cfs_proc,
+	.put	 = put_cfs_proc,
+	.get	 = get_cfs_proc,
+	.steal	 = get_cfs_proc,
+	.pull	 = pull_cfs_proc,
+	.find	 = find_cfs_proc,
+	.tick	 = tick_cfs,
+	.migrate = migrate_cfs,
+};
@@ -0,0 +1,94 @@
+/*
+ * Earliest deadline first class. It runs ahead of the selected policy
+ * on every CPU: each run queue keeps its admitted real time processes
+ * in a binary min-heap keyed by absolute deadline.
+ *
+ * Admission is a density test per CPU: a process needing C slots
+ * within D slots of its release adds C / D, and a CPU takes it only
+ * while the sum stays at or below 1. Admitted processes stay on their
+ * CPU, so the test holds for each CPU on its own.
+ */
+
+#include "sched.h"
+
+#include <stdlib.h>
+
+#define heap_key(rq, i) ((rq)->heap[i]->deadline)
+
+static void swap(struct edf_rq *rq, int a, int b) {
+	struct pcb_t *tmp = rq->heap[a];
+	rq->heap[a] = rq->heap[b];
+	rq->heap[b] = tmp;
+}
+
+/* Density of [proc] in EDF_DENSITY_ONE units */
+static long density(struct pcb_t *proc) {
+	/* Released past its deadline already: never admissible */
+	if (proc->deadline <= proc->arrival)
+		return EDF_DENSITY_ONE + 1;
+	return (long)(proc->code->size * EDF_DENSITY_ONE /
+			(proc->deadline - proc->arrival));
+}
+
+int edf_admit(struct edf_rq * rq, struct pcb_t * proc) {
+	long d = density(proc);
+
+	if (rq->density + d > EDF_DENSITY_ONE)
+		return -1;
+	/* Placement reads it without the lock */
+	__atomic_fetch_add(&rq->density, d, __ATOMIC_RELAXED);
+	return 0;
+}
+
+void edf_release(struct edf_rq * rq, struct pcb_t * proc) {
+	__atomic_fetch_sub(&rq->density, density(proc), __ATOMIC_RELAXED);
+}
+
+void edf_push(struct edf_rq * rq, struct pcb_t * proc) {
+	int i, parent;
+
+	if (rq->nr == rq->cap) {
+		rq->cap = rq->cap ? rq->cap * 2 : 16;
+		rq->heap = realloc(rq->heap, rq->cap * sizeof(struct pcb_t *));
+	}
+	i = rq->nr++;
+	rq->heap[i] = proc;
+	/* Sift up */
+	while (i > 0) {
+		parent = (i - 1) / 2;
+		if (heap_key(rq, parent) <= heap_key(rq, i))
+			break;
+		swap(rq, i, parent);
+		i = parent;
+	}
+}
+
+struct pcb_t * edf_find(struct edf_rq * rq, uint32_t pid) {
+	int i;
+
+	for (i = 0; i < rq->nr; i++)
+		if (rq->heap[i]->pid == pid)
+			return rq->heap[i];
+	return NULL;
+}
+
+struct pcb_t * edf_pop(struct edf_rq * rq) {
+	struct pcb_t *proc;
+	int i = 0, child;
+
+	if (rq->nr == 0)
+		return NULL;
+	proc = rq->heap[0];
+	rq->heap[0] = rq->heap[--rq->nr];
+	/* Sift down */
+	while ((child = 2 * i + 1) < rq->nr) {
+		if (child + 1 < rq->nr &&
+		    heap_key(rq, child + 1) < heap_key(rq, child))
+			child++;
+		if (heap_key(rq, i) <= heap_key(rq, child))
+			break;
+		swap(rq, i, child);
+		i = child;
+	}
+	return proc;
+}
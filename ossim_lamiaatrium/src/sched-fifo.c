@@ -0,0 +1,40 @@
+/*
+ * FIFO policy: a single round robin queue, prio is ignored
+ */
+
+#include "queue.h"
+#include "sched.h"
+
+#include <stdlib.h>
+
+static void *init_fifo(void) {
+	/* An all zero queue_t is an empty queue */
+	return calloc(1, sizeof(struct queue_t));
+}
+
+static struct pcb_t *get_fifo_proc(void *rq) {
+	struct pcb_t * proc = NULL;
+
+	if(!empty(rq))
+		proc = dequeue(rq);
+	return proc;
+}
+
+static void put_fifo_proc(void *rq, struct pcb_t * proc) {
+	enqueue(rq, proc);
+}
+
+static struct pcb_t *find_fifo_proc(void *rq, uint32_t pid) {
+	return queue_find(rq, pid);
+}
+
+const struct sched_ops fifo_sched_ops = {
+	.name	= "fifo",
+	.init	= init_fifo,
+	.add	= put_fifo_proc,
+	.put	= put_fifo_proc,
+	.get	= get_fifo_proc,
+	.steal	= get_fifo_proc,
+	.pull	= get_fifo_proc,
+	.find	= find_fifo_proc,
+};
@@ -0,0 +1,133 @@
+/*
+ * MLFQ policy: MLFQ_LEVELS round robin queues, the lower the level the
+ * longer the quantum (time_slot << level). A process starts on level 0
+ * and sinks one level each time it uses up its whole slice, so CPU
+ * bound work ends up running long slices with few context switches.
+ * One that spends at least half of its slice on READ, WRITE or SYSCALL
+ * rises one level. Every MLFQ_BOOST_INTERVAL time slots all waiting
+ * processes go back to level 0, so the low levels do not starve.
+ */
+
+#include "queue.h"
+#include "sched.h"
+#include "timer.h"
+
+#include <stdlib.h>
+
+#define MLFQ_LEVELS 4
+#define MLFQ_BOOST_INTERVAL 64
+
+struct mlfq_rq {
+	struct queue_t level[MLFQ_LEVELS];
+	unsigned ready;			/* bit l set while level[l] is not empty */
+	uint64_t last_boost;
+};
+
+static void *init_mlfq(void) {
+	/* An all zero queue_t is an empty queue */
+	return calloc(1, sizeof(struct mlfq_rq));
+}
+
+static void mlfq_enqueue(struct mlfq_rq *rq, struct pcb_t *proc) {
+	enqueue(&rq->level[proc->level], proc);
+	rq->ready |= 1U << proc->level;
+}
+
+static struct pcb_t *mlfq_take(struct mlfq_rq *rq, int level) {
+	struct pcb_t *proc = dequeue(&rq->level[level]);
+	if (empty(&rq->level[level]))
+		rq->ready &= ~(1U << level);
+	return proc;
+}
+
+/* Move every waiting process back to level 0 */
+static void mlfq_boost(struct mlfq_rq *rq) {
+	struct pcb_t *proc;
+	int l;
+
+	for (l = 1; l < MLFQ_LEVELS; l++) {
+		while ((proc = mlfq_take(rq, l)) != NULL) {
+			proc->level = 0;
+			mlfq_enqueue(rq, proc);
+		}
+	}
+}
+
+static struct pcb_t *get_mlfq_proc(void *data) {
+	struct mlfq_rq *rq = data;
+	uint64_t now = current_time();
+
+	if (now - rq->last_boost >= MLFQ_BOOST_INTERVAL) {
+		rq->last_boost = now;
+		mlfq_boost(rq);
+	}
+	if (rq->ready == 0)
+		return NULL;
+	return mlfq_take(rq, __builtin_ctz(rq->ready));
+}
+
+/* Migration candidate for rebalancing: from the lowest level */
+static struct pcb_t *pull_mlfq_proc(void *data) {
+	struct mlfq_rq *rq = data;
+
+	if (rq->ready == 0)
+		return NULL;
+	return mlfq_take(rq, 31 - __builtin_clz(rq->ready));
+}
+
+static struct pcb_t *find_mlfq_proc(void *data, uint32_t pid) {
+	struct mlfq_rq *rq = data;
+	struct pcb_t *proc;
+	int l;
+
+	for (l = 0; l < MLFQ_LEVELS; l++)
+		if ((proc = queue_find(&rq->level[l], pid)) != NULL)
+			return proc;
+	return NULL;
+}
+
+static void add_mlfq_proc(void *data, struct pcb_t *proc) {
+	proc->level = 0;
+	mlfq_enqueue(data, proc);
+}
+
+static void put_mlfq_proc(void *data, struct pcb_t *proc) {
+	mlfq_enqueue(data, proc);
+}
+
+/* Feedback on the slice that just ended */
+static void tick_mlfq(struct pcb_t *proc, uint64_t slots) {
+	uint32_t io = proc->nr_io - proc->nr_io_seen;
+
+	proc->nr_io_seen = proc->nr_io;
+	if (io * 2 >= slots && io > 0) {
+		if (proc->level > 0)
+			proc->level--;
+	} else if (slots >= proc->slice) {
+		if (proc->level < MLFQ_LEVELS - 1)
+			proc->level++;
+	}
+}
+
+static int quantum_mlfq(struct pcb_t *proc, int time_slot) {
+	return time_slot << proc->level;
+}
+
+/* Arrivals start on level 0 and preempt processes of lower levels */
+static long rank_mlfq(struct pcb_t *proc) {
+	return proc->level;
+}
+
+const struct sched_ops mlfq_sched_ops = {
+	.name	 = "mlfq",
+	.init	 = init_mlfq,
+	.add	 = add_mlfq_proc,
+	.put	 = put_mlfq_proc,
+	.get	 = get_mlfq_proc,
+	.steal	 = get_mlfq_proc,
+	.pull	 = pull_mlfq_proc,
+	.find	 = find_mlfq_proc,
+	.tick	 = tick_mlfq,
+	.quantum = quantum_mlfq,
+	.rank	 = rank_mlfq,
+};
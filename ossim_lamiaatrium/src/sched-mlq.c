@@ -0,0 +1,191 @@
+/*
+ * Copyright (C) 2026 pdnguyen of HCMC University of Technology VNU-HCM
+ */
+
+/* LamiaAtrium release
+ * Source Code License Grant: The authors hereby grant to Licensee
+ * personal permission to use and modify the Licensed Source Code
+ * for the sole purpose of studying while attending the course CO2018.
+ */
+
+/*
+ * MLQ policy: one round robin queue per priority. In a round, queue
+ * prio may dispatch MAX_PRIO - prio processes before the next queue
+ * gets its turn.
+ */
+
+#include "queue.h"
+#include "sched.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define MLQ_WORDS ((MAX_PRIO + 63) / 64)
+
+struct mlq_rq {
+	struct queue_t mlq_ready_queue[MAX_PRIO];
+	int current_slot[MAX_PRIO];	//number of proc taken out
+	int current_prior;		//prior that we are processing
+
+	/*
+	 * ready: bit prio is set while mlq_ready_queue[prio] is not empty
+	 * spent: bit prio is set once prio used up its slot in this round
+	 * current_slot[prio] only counts when slot_epoch[prio] == epoch,
+	 * so starting a new round is a single epoch bump instead of a reset
+	 * of every current_slot entry.
+	 */
+	uint64_t ready[MLQ_WORDS];
+	uint64_t spent[MLQ_WORDS];
+	unsigned long slot_epoch[MAX_PRIO];
+	unsigned long epoch;
+};
+
+static void *init_mlq(void) {
+	/* An all zero queue_t is an empty queue */
+	struct mlq_rq *rq = calloc(1, sizeof(struct mlq_rq));
+	rq->epoch = 1;
+	return rq;
+}
+
+static inline void mlq_set(uint64_t *map, int prio) {
+	map[prio / 64] |= 1ULL << (prio % 64);
+}
+
+static inline void mlq_clear(uint64_t *map, int prio) {
+	map[prio / 64] &= ~(1ULL << (prio % 64));
+}
+
+/* First prio in [from, to) which is ready and still has quota, or -1 */
+static int mlq_find(struct mlq_rq *rq, int from, int to) {
+	int w;
+	for (w = from / 64; w * 64 < to; w++) {
+		uint64_t bits = rq->ready[w] & ~rq->spent[w];
+		if (w == from / 64)
+			bits &= ~0ULL << (from % 64);
+		if (bits) {
+			int prio = w * 64 + __builtin_ctzll(bits);
+			return (prio < to) ? prio : -1;
+		}
+	}
+	return -1;
+}
+
+/* Take the head of mlq_ready_queue[prio], keeping the bitmap in sync */
+static struct pcb_t *mlq_take(struct mlq_rq *rq, int prio) {
+	struct pcb_t *proc = dequeue(&rq->mlq_ready_queue[prio]);
+	if (empty(&rq->mlq_ready_queue[prio]))
+		mlq_clear(rq->ready, prio);
+	return proc;
+}
+
+/*
+ *  Stateful design for routine calling
+ *  based on the priority and our MLQ policy
+ *  We implement stateful here using transition technique
+ *  State representation   prio = 0 .. MAX_PRIO, curr_slot = 0..(MAX_PRIO - prio)
+ */
+static struct pcb_t * get_mlq_proc(void *data) {
+	struct mlq_rq *rq = data;
+	struct pcb_t * proc = NULL;
+
+	/*
+	 * current_prior tracks the prior that we are extracting, the search
+	 * wraps around once like a full pass over MAX_PRIO queues would
+	 * */
+	int prio = mlq_find(rq, rq->current_prior, MAX_PRIO);
+	if (prio < 0)
+		prio = mlq_find(rq, 0, rq->current_prior);
+
+	if (prio >= 0)
+	{
+		rq->current_prior = prio;
+		proc = mlq_take(rq, prio);
+
+		if (rq->slot_epoch[prio] != rq->epoch) {
+			rq->slot_epoch[prio] = rq->epoch;
+			rq->current_slot[prio] = 0;
+		}
+		if (++rq->current_slot[prio] >= MAX_PRIO - prio)
+			mlq_set(rq->spent, prio);
+
+		return proc;
+	}
+
+	// next round occur
+	rq->current_prior = 0;
+	rq->epoch++;
+	for(int i = 0; i < MLQ_WORDS; i++)
+	{
+		rq->spent[i] = 0;
+	}
+
+	return NULL;
+}
+
+/* Steal candidate: most urgent ready process regardless of quota */
+static struct pcb_t *steal_mlq_proc(void *data) {
+	struct mlq_rq *rq = data;
+	int w;
+	for (w = 0; w < MLQ_WORDS; w++)
+		if (rq->ready[w])
+			return mlq_take(rq, w * 64 + __builtin_ctzll(rq->ready[w]));
+	return NULL;
+}
+
+/* Migration candidate for rebalancing: least urgent ready process */
+static struct pcb_t *pull_mlq_proc(void *data) {
+	struct mlq_rq *rq = data;
+	int w;
+	for (w = MLQ_WORDS - 1; w >= 0; w--)
+		if (rq->ready[w])
+			return mlq_take(rq, w * 64 + 63 - __builtin_clzll(rq->ready[w]));
+	return NULL;
+}
+
+static struct pcb_t *find_mlq_proc(void *data, uint32_t pid) {
+	struct mlq_rq *rq = data;
+	struct pcb_t *proc;
+	int w;
+	for (w = 0; w < MLQ_WORDS; w++) {
+		uint64_t bits = rq->ready[w];
+		while (bits) {
+			int prio = w * 64 + __builtin_ctzll(bits);
+			proc = queue_find(&rq->mlq_ready_queue[prio], pid);
+			if (proc)
+				return proc;
+			bits &= bits - 1;
+		}
+	}
+	return NULL;
+}
+
+static void put_mlq_proc(void *data, struct pcb_t * proc) {
+	struct mlq_rq *rq = data;
+	enqueue(&rq->mlq_ready_queue[proc->prio], proc);
+	mlq_set(rq->ready, proc->prio);
+}
+
+/* An arrival more urgent than the queue being served is served next */
+static void add_mlq_proc(void *data, struct pcb_t * proc) {
+	struct mlq_rq *rq = data;
+
+	put_mlq_proc(rq, proc);
+	if ((int)proc->prio < rq->current_prior)
+		rq->current_prior = proc->prio;
+}
+
+static long rank_mlq(struct pcb_t * proc) {
+	return proc->prio;
+}
+
+const struct sched_ops mlq_sched_ops = {
+	.name	= "mlq",
+	.init	= init_mlq,
+	.add	= add_mlq_proc,
+	.put	= put_mlq_proc,
+	.get	= get_mlq_proc,
+	.steal	= steal_mlq_proc,
+	.pull	= pull_mlq_proc,
+	.find	= find_mlq_proc,
+	.rank	= rank_mlq,
+};
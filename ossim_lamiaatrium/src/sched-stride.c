@@ -0,0 +1,89 @@
+/*
+ * Stride policy: the deterministic form of lottery scheduling. A
+ * process holds MAX_PRIO - prio tickets, its stride is inversely
+ * proportional to them and its pass advances by one stride per time
+ * slot it runs. The process with the smallest pass runs next, so over
+ * time every process gets CPU in proportion to its tickets.
+ */
+
+#include "sched.h"
+
+#include <stdlib.h>
+
+#define STRIDE1 (1 << 20)	/* stride of a process with one ticket */
+
+struct stride_rq {
+	struct rb_root tree;		/* ready processes by pass */
+	uint64_t global_pass;		/* pass of the last dispatch */
+};
+
+/* The pass lives in pcb_t.vruntime */
+static inline uint64_t stride_of(struct pcb_t *proc) {
+	return STRIDE1 / (MAX_PRIO - proc->prio);
+}
+
+static void *init_stride(void) {
+	return calloc(1, sizeof(struct stride_rq));
+}
+
+static struct pcb_t *get_stride_proc(void *data) {
+	struct stride_rq *rq = data;
+	struct pcb_t *proc = vtree_take(&rq->tree, rb_first(&rq->tree));
+
+	if (proc && proc->vruntime > rq->global_pass)
+		__atomic_store_n(&rq->global_pass, proc->vruntime,
+				__ATOMIC_RELAXED);
+	return proc;
+}
+
+static struct pcb_t *pull_stride_proc(void *data) {
+	struct stride_rq *rq = data;
+	return vtree_take(&rq->tree, rb_last(&rq->tree));
+}
+
+/* A newcomer joins one stride after the current global pass */
+static void add_stride_proc(void *data, struct pcb_t *proc) {
+	struct stride_rq *rq = data;
+
+	proc->vruntime = rq->global_pass + stride_of(proc);
+	vtree_insert(&rq->tree, proc);
+}
+
+/* A process lagging by more than a stride does not get to monopolize
+ * the CPU */
+static void put_stride_proc(void *data, struct pcb_t *proc) {
+	struct stride_rq *rq = data;
+
+	if (proc->vruntime + stride_of(proc) < rq->global_pass)
+		proc->vruntime = rq->global_pass - stride_of(proc);
+	vtree_insert(&rq->tree, proc);
+}
+
+static void tick_stride(struct pcb_t *proc, uint64_t slots) {
+	proc->vruntime += slots * stride_of(proc);
+}
+
+static void migrate_stride(struct pcb_t *proc, void *from, void *to) {
+	proc->vruntime += __atomic_load_n(&((struct stride_rq *)to)->global_pass,
+			__ATOMIC_RELAXED);
+	proc->vruntime -= __atomic_load_n(&((struct stride_rq *)from)->global_pass,
+			__ATOMIC_RELAXED);
+}
+
+static struct pcb_t *find_stride_proc(void *data, uint32_t pid) {
+	struct stride_rq *rq = data;
+	return vtree_find(&rq->tree, pid);
+}
+
+const struct sched_ops stride_sched_ops = {
+	.name	 = "stride",
+	.init	 = init_stride,
+	.add	 = add_stride_proc,
+	.put	 = put_stride_proc,
+	.get	 = get_stride_proc,
+	.steal	 = get_stride_proc,
+	.pull	 = pull_stride_proc,
+	.find	 = find_stride_proc,
+	.tick	 = tick_stride,
+	.migrate = migrate_stride,
+};
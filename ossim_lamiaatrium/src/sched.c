@@ -10,180 +10,567 @@
 
 #include "queue.h"
 #include "sched.h"
+#include "timer.h"
 #include <pthread.h>
 
+#include <limits.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 
-static struct queue_t ready_queue;
-static struct queue_t run_queue;
-static pthread_mutex_t queue_lock;
+/* Registered policies, the first one is the default */
+static const struct sched_ops * const policies[] = {
+	&mlq_sched_ops,
+	&fifo_sched_ops,
+	&mlfq_sched_ops,
+	&stride_sched_ops,
+	&cfs_sched_ops,
+};
+#define NR_POLICIES ((int)(sizeof(policies) / sizeof(policies[0])))
 
-static struct queue_t running_list;
+static const struct sched_ops *policy = &mlq_sched_ops;
 
-#ifdef MLQ_SCHED
-static struct queue_t mlq_ready_queue[MAX_PRIO];
-static int slot[MAX_PRIO]; //quota
-static int current_slot[MAX_PRIO]; //number of proc taken out
-static int current_prior = 0; //prior that we are processing
+/*
+ * Every CPU owns one run queue and only takes its own lock on the
+ * dispatch path. A CPU whose queue ran dry steals from a peer, and
+ * every SCHED_REBALANCE_INTERVAL dispatches it pulls work from the
+ * busiest peer so the queues do not drift apart. What the run queue
+ * holds is up to the policy, in [state].
+ */
+struct runqueue_t {
+	pthread_mutex_t lock;
+	int nr_ready;			/* processes waiting, inbox included */
+	unsigned long nr_pick;		/* dispatches, drives rebalancing */
+	void *state;			/* policy's per run queue state */
+	struct edf_rq edf;		/* real time processes, run first */
+	uint64_t curr_deadline;		/* of the running process, or NONE */
+	long curr_rank;			/* rank of the running process */
+	int need_resched;		/* set by add_proc, read by the CPU */
+#ifdef QUEUE_LOCKFREE
+	/* Arrivals are handed off here without taking the lock */
+	struct lfqueue_t inbox;
+#endif
+} __attribute__((aligned(64)));
+
+#define RANK_IDLE LONG_MIN		/* nothing to preempt */
+#define NO_DEADLINE UINT64_MAX
+
+static struct runqueue_t *runqueue;
+static struct queue_t *running_list;	/* one per CPU, owned by that CPU */
+static pthread_mutex_t *running_lock;	/* taken to change or search one */
+static int nr_rqs;
+static int next_rq;
+
+/* nr_ready is read without the lock by peers and the placement logic */
+static inline int rq_load(struct runqueue_t *rq) {
+	return __atomic_load_n(&rq->nr_ready, __ATOMIC_RELAXED);
+}
+
+static inline void rq_account(struct runqueue_t *rq, int n) {
+	__atomic_add_fetch(&rq->nr_ready, n, __ATOMIC_RELAXED);
+}
+
+int set_sched_policy(const char * name) {
+	int i;
+	for (i = 0; i < NR_POLICIES; i++) {
+		if (strcmp(name, policies[i]->name) == 0) {
+			policy = policies[i];
+			return 0;
+		}
+	}
+	return -1;
+}
+
+const char * const * sched_policy_names(void) {
+	static const char *names[NR_POLICIES + 1];
+	int i;
+	for (i = 0; i < NR_POLICIES; i++)
+		names[i] = policies[i]->name;
+	return names;
+}
+
+void vtree_insert(struct rb_root * tree, struct pcb_t * proc) {
+	struct rb_node **link = &tree->node, *parent = NULL;
+
+	/* Equal keys go right, so ties run in arrival order */
+	while (*link) {
+		parent = *link;
+		if (proc->vruntime < rb_entry(parent, struct pcb_t, run_node)->vruntime)
+			link = &parent->left;
+		else
+			link = &parent->right;
+	}
+	rb_link_node(&proc->run_node, parent, link);
+	rb_insert_color(&proc->run_node, tree);
+}
+
+struct pcb_t * vtree_take(struct rb_root * tree, struct rb_node * node) {
+	if (node == NULL)
+		return NULL;
+	rb_erase(node, tree);
+	return rb_entry(node, struct pcb_t, run_node);
+}
+
+/* The tree is keyed by vruntime, not by pid: visit every node */
+static struct pcb_t *vtree_find_node(struct rb_node *node, uint32_t pid) {
+	struct pcb_t *proc;
+
+	if (node == NULL)
+		return NULL;
+	proc = rb_entry(node, struct pcb_t, run_node);
+	if (proc->pid == pid)
+		return proc;
+	if ((proc = vtree_find_node(node->left, pid)) != NULL)
+		return proc;
+	return vtree_find_node(node->right, pid);
+}
+
+struct pcb_t * vtree_find(struct rb_root * tree, uint32_t pid) {
+	return vtree_find_node(tree->node, pid);
+}
+
+static void migrate(struct pcb_t *proc, struct runqueue_t *from,
+		    struct runqueue_t *to) {
+	if (policy->migrate)
+		policy->migrate(proc, from->state, to->state);
+}
+
+/* Charge the slots [proc] just ran, the CPU is idle until the next pick */
+static void account_exec(struct pcb_t *proc) {
+	struct runqueue_t *rq = &runqueue[proc->cpu];
+	uint64_t delta = current_time() - proc->exec_start;
 
+	proc->sum_exec += delta;
+	if (policy->tick && !proc->rt)
+		policy->tick(proc, delta);
+	__atomic_store_n(&rq->curr_rank, RANK_IDLE, __ATOMIC_RELAXED);
+	__atomic_store_n(&rq->curr_deadline, NO_DEADLINE, __ATOMIC_RELAXED);
+}
+
+/* Move arrivals handed off through the inbox to the ready queues */
+static void rq_drain(struct runqueue_t *rq) {
+#ifdef QUEUE_LOCKFREE
+	struct pcb_t *proc;
+	while ((proc = lfq_dequeue(&rq->inbox)) != NULL)
+		policy->add(rq->state, proc);
 #endif
+}
 
 int queue_empty(void) {
-#ifdef MLQ_SCHED
-	unsigned long prio;
-	for (prio = 0; prio < MAX_PRIO; prio++)
-		if(!empty(&mlq_ready_queue[prio])) 
-			return -1;
-#endif
-	return (empty(&ready_queue) && empty(&run_queue));
+	int i;
+	for (i = 0; i < nr_rqs; i++)
+		if (rq_load(&runqueue[i]))
+			return 0;
+	return 1;
 }
 
-void init_scheduler(void) {
-#ifdef MLQ_SCHED
-    int i ;
+void init_scheduler(int nr_cpus) {
+	int i;
 
-	for (i = 0; i < MAX_PRIO; i ++) {
-		mlq_ready_queue[i].size = 0;
-		slot[i] = MAX_PRIO - i; 
-		current_slot[i] = 0;
+	nr_rqs = (nr_cpus > 0) ? nr_cpus : 1;
+	runqueue = aligned_alloc(64, sizeof(struct runqueue_t) * nr_rqs);
+	running_list = calloc(nr_rqs, sizeof(struct queue_t));
+	running_lock = malloc(nr_rqs * sizeof(pthread_mutex_t));
+	next_rq = 0;
+
+	/* An all zero queue is an empty queue, the inbox included */
+	memset(runqueue, 0, sizeof(struct runqueue_t) * nr_rqs);
+	for (i = 0; i < nr_rqs; i++) {
+		pthread_mutex_init(&runqueue[i].lock, NULL);
+		pthread_mutex_init(&running_lock[i], NULL);
+		runqueue[i].state = policy->init();
+		runqueue[i].curr_rank = RANK_IDLE;
+		runqueue[i].curr_deadline = NO_DEADLINE;
 	}
-#endif
-	ready_queue.size = 0;
-	run_queue.size = 0;
-	running_list.size = 0;
-	pthread_mutex_init(&queue_lock, NULL);
-}
-
-#ifdef MLQ_SCHED
-/* 
- *  Stateful design for routine calling
- *  based on the priority and our MLQ policy
- *  We implement stateful here using transition technique
- *  State representation   prio = 0 .. MAX_PRIO, curr_slot = 0..(MAX_PRIO - prio)
- */
-struct pcb_t * get_mlq_proc(void) {
-	struct pcb_t * proc = NULL;
+}
+
+/* Take one process from the first peer queue which has some to spare */
+static struct pcb_t *steal_proc(int cpu) {
+	int i;
+	for (i = 1; i < nr_rqs; i++) {
+		struct runqueue_t *victim = &runqueue[(cpu + i) % nr_rqs];
+		struct pcb_t *proc = NULL;
+
+		if (rq_load(victim) == 0)
+			continue;
+#ifdef QUEUE_LOCKFREE
+		/* Fresh arrivals can be taken without the victim's lock,
+		 * they still join through add() like any arrival */
+		if ((proc = lfq_dequeue(&victim->inbox)) != NULL) {
+			struct runqueue_t *rq = &runqueue[cpu];
 
-	pthread_mutex_lock(&queue_lock);
-	/*TODO: get a process from PRIORITY [ready_queue].
-	 *      It worth to protect by a mechanism.
-
-	 * int processed_priorities starts counting when a mlq_ready_queue cant be taken out anymore
-	 * current_prior tracks the prior that we are extracting
-	 * */
-	int processed_priorities = 0;
-
-	while(processed_priorities < MAX_PRIO)
-	{
-		if(!empty(&mlq_ready_queue[current_prior]) && 
-			current_slot[current_prior] < slot[current_prior])
-		{
-			proc = dequeue(&mlq_ready_queue[current_prior]);
-			current_slot[current_prior]++;
-			if(proc) enqueue(&running_list, proc);
-			pthread_mutex_unlock(&queue_lock);
+			rq_account(rq, 1);
+			rq_account(victim, -1);
+			pthread_mutex_lock(&rq->lock);
+			policy->add(rq->state, proc);
+			proc = policy->get(rq->state);
+			pthread_mutex_unlock(&rq->lock);
+			if (proc)
+				rq_account(rq, -1);
+			return proc;
+		}
+#endif
+		if (pthread_mutex_trylock(&victim->lock) != 0)
+			continue;
+		proc = policy->steal(victim->state);
+		pthread_mutex_unlock(&victim->lock);
+		if (proc) {
+			rq_account(victim, -1);
+			migrate(proc, victim, &runqueue[cpu]);
 			return proc;
 		}
-		
-		processed_priorities++;
-		current_prior++;
-		if(current_prior >= MAX_PRIO) current_prior = 0;
 	}
+	return NULL;
+}
+
+/* Pull half of the imbalance with the busiest peer into [cpu]'s queue */
+static void rebalance(int cpu) {
+	struct pcb_t *moved[SCHED_MIGRATE_BATCH];
+	struct runqueue_t *this_rq = &runqueue[cpu];
+	struct runqueue_t *busiest = NULL;
+	int i, n, nr_moved = 0;
 
-	// next round occur
-	current_prior = 0;
-	for(int i = 0; i < MAX_PRIO; i++)
-	{
-		current_slot[i] = 0;
+	for (i = 0; i < nr_rqs; i++) {
+		if (i == cpu)
+			continue;
+		if (busiest == NULL || rq_load(&runqueue[i]) > rq_load(busiest))
+			busiest = &runqueue[i];
 	}
+	if (busiest == NULL)
+		return;
+
+	n = (rq_load(busiest) - rq_load(this_rq)) / 2;
+	if (n <= 0)
+		return;
+	if (n > SCHED_MIGRATE_BATCH)
+		n = SCHED_MIGRATE_BATCH;
+
+	if (pthread_mutex_trylock(&busiest->lock) != 0)
+		return;
+	rq_drain(busiest);
+	while (nr_moved < n &&
+	       (moved[nr_moved] = policy->pull(busiest->state)) != NULL)
+		nr_moved++;
+	pthread_mutex_unlock(&busiest->lock);
 
-	pthread_mutex_unlock(&queue_lock);
-	return NULL;	
+	/* Count them here first so queue_empty() never misses them */
+	rq_account(this_rq, nr_moved);
+	rq_account(busiest, -nr_moved);
+
+	pthread_mutex_lock(&this_rq->lock);
+	for (i = 0; i < nr_moved; i++) {
+		migrate(moved[i], busiest, this_rq);
+		policy->put(this_rq->state, moved[i]);
+	}
+	pthread_mutex_unlock(&this_rq->lock);
 }
 
-void put_mlq_proc(struct pcb_t * proc) {
-	proc->krnl->ready_queue = &ready_queue;
-	proc->krnl->mlq_ready_queue = mlq_ready_queue;
-	proc->krnl->running_list = &running_list;
+struct pcb_t * get_proc(int cpu) {
+	struct runqueue_t *rq = &runqueue[cpu];
+	struct pcb_t * proc = NULL;
+
+	if (nr_rqs > 1 && ++rq->nr_pick % SCHED_REBALANCE_INTERVAL == 0)
+		rebalance(cpu);
 
-	/* TODO: put running proc to running_list 
-	 *       It worth to protect by a mechanism.
-	 * 
-	 */
+	pthread_mutex_lock(&rq->lock);
+	rq_drain(rq);
+	proc = edf_pop(&rq->edf);
+	if (proc == NULL)
+		proc = policy->get(rq->state);
+	pthread_mutex_unlock(&rq->lock);
 
-	pthread_mutex_lock(&queue_lock);
-	purgequeue(&running_list, proc);
-	enqueue(&mlq_ready_queue[proc->prio], proc);
-	pthread_mutex_unlock(&queue_lock);
+	if (proc)
+		rq_account(rq, -1);
+	else if (rq_load(rq) == 0 && nr_rqs > 1)
+		proc = steal_proc(cpu);
+
+	__atomic_store_n(&rq->need_resched, 0, __ATOMIC_RELAXED);
+	if (proc) {
+		proc->cpu = cpu;
+		proc->exec_start = current_time();
+		pthread_mutex_lock(&running_lock[cpu]);
+		enqueue(&running_list[cpu], proc);
+		pthread_mutex_unlock(&running_lock[cpu]);
+		__atomic_store_n(&rq->curr_deadline,
+				proc->rt ? proc->deadline : NO_DEADLINE,
+				__ATOMIC_RELAXED);
+		if (policy->rank && !proc->rt)
+			__atomic_store_n(&rq->curr_rank, policy->rank(proc),
+					__ATOMIC_RELAXED);
+	}
+	return proc;
 }
 
-void add_mlq_proc(struct pcb_t * proc) {
-	proc->krnl->ready_queue = &ready_queue;
-	proc->krnl->mlq_ready_queue = mlq_ready_queue;
-	proc->krnl->running_list = &running_list;
+int need_resched(int cpu) {
+	return __atomic_load_n(&runqueue[cpu].need_resched, __ATOMIC_RELAXED);
+}
 
-	/* TODO: put running proc to running_list
-	 *       It worth to protect by a mechanism.
-	 * 
-	 */
-       
-	pthread_mutex_lock(&queue_lock);
-	purgequeue(&running_list, proc);
-	enqueue(&mlq_ready_queue[proc->prio], proc);
-	pthread_mutex_unlock(&queue_lock);	
+/* The CPU running the least urgent process ranked above [rank], or -1 */
+static int find_preempt_target(long rank) {
+	long worst = rank;
+	int i, cpu = -1;
+
+	for (i = 0; i < nr_rqs; i++) {
+		long curr = __atomic_load_n(&runqueue[i].curr_rank,
+				__ATOMIC_RELAXED);
+		if (curr > worst) {
+			worst = curr;
+			cpu = i;
+		}
+	}
+	return cpu;
 }
 
-struct pcb_t * get_proc(void) {
-	return get_mlq_proc();
+int get_quantum(struct pcb_t * proc, int time_slot) {
+	proc->slice = policy->quantum ?
+		policy->quantum(proc, time_slot) : time_slot;
+	return proc->slice;
 }
 
-void put_proc(struct pcb_t * proc) {
-	return put_mlq_proc(proc);
+/* Queue [proc] back on the run queue of proc->cpu */
+static void requeue(struct pcb_t * proc) {
+	struct runqueue_t *rq = &runqueue[proc->cpu];
+
+	rq_account(rq, 1);
+	pthread_mutex_lock(&rq->lock);
+	if (proc->rt)
+		edf_push(&rq->edf, proc);
+	else
+		policy->put(rq->state, proc);
+	pthread_mutex_unlock(&rq->lock);
 }
 
-void add_proc(struct pcb_t * proc) {
-	return add_mlq_proc(proc);
+/* Other CPUs search the list in find_proc_safe() while it changes */
+static void running_del(struct pcb_t * proc) {
+	pthread_mutex_lock(&running_lock[proc->cpu]);
+	purgequeue(&running_list[proc->cpu], proc);
+	pthread_mutex_unlock(&running_lock[proc->cpu]);
 }
-#else
-struct pcb_t * get_proc(void) {
-	struct pcb_t * proc = NULL;
 
-	pthread_mutex_lock(&queue_lock);
-	/*TODO: get a process from [ready_queue].
-	 *       It worth to protect by a mechanism.
-	 * 
-	 */
-	if(!empty(&ready_queue)) proc = dequeue(&ready_queue);
-	pthread_mutex_unlock(&queue_lock);
+struct pcb_t * find_ready_proc(uint32_t pid) {
+	struct pcb_t *proc = NULL;
+	int i;
 
+	for (i = 0; i < nr_rqs && proc == NULL; i++) {
+		struct runqueue_t *rq = &runqueue[i];
+
+		pthread_mutex_lock(&rq->lock);
+		rq_drain(rq);
+		proc = edf_find(&rq->edf, pid);
+		if (proc == NULL)
+			proc = policy->find(rq->state, pid);
+		pthread_mutex_unlock(&rq->lock);
+	}
 	return proc;
 }
 
 void put_proc(struct pcb_t * proc) {
-	proc->krnl->ready_queue = &ready_queue;
-	proc->krnl->running_list = &running_list;
+	/* The running list belongs to proc->cpu, the caller */
+	running_del(proc);
+	account_exec(proc);
+	requeue(proc);
+}
 
-	/* TODO: put running proc to running_list 
-	 *       It worth to protect by a mechanism.
-	 * 
-	 */
-	pthread_mutex_lock(&queue_lock);
-	enqueue(&ready_queue, proc);
-	pthread_mutex_unlock(&queue_lock);
+static int nr_asleep;
+
+/* Timer event: the sleep is over */
+static void wake_proc(struct wheel_timer * timer) {
+	struct pcb_t *proc = wheel_entry(timer, struct pcb_t, sleep_timer);
+
+	proc->sleep_until = 0;
+	requeue(proc);
+	__atomic_sub_fetch(&nr_asleep, 1, __ATOMIC_RELAXED);
+}
+
+void sleep_proc(struct pcb_t * proc) {
+	running_del(proc);
+	account_exec(proc);
+
+	/* Counted until it is queued again, so no CPU stops meanwhile */
+	__atomic_add_fetch(&nr_asleep, 1, __ATOMIC_RELAXED);
+	proc->sleep_timer.expires = proc->sleep_until;
+	proc->sleep_timer.fn = wake_proc;
+	timer_add(&proc->sleep_timer);
+}
+
+int proc_asleep(void) {
+	return __atomic_load_n(&nr_asleep, __ATOMIC_RELAXED) > 0;
+}
+
+/*
+ * Admit a process with a deadline to the EDF class of the CPU with the
+ * most spare density, or of any CPU where it fits. -1 if none has room,
+ * the process then runs under the policy like any other.
+ */
+static int add_rt_proc(struct pcb_t * proc) {
+	int i, best = 0;
+
+	for (i = 1; i < nr_rqs; i++)
+		if (__atomic_load_n(&runqueue[i].edf.density, __ATOMIC_RELAXED) <
+		    __atomic_load_n(&runqueue[best].edf.density, __ATOMIC_RELAXED))
+			best = i;
+
+	for (i = 0; i < nr_rqs; i++) {
+		struct runqueue_t *rq = &runqueue[(best + i) % nr_rqs];
+
+		pthread_mutex_lock(&rq->lock);
+		if (edf_admit(&rq->edf, proc) < 0) {
+			pthread_mutex_unlock(&rq->lock);
+			continue;
+		}
+		proc->rt = 1;
+		proc->cpu = (best + i) % nr_rqs;
+		rq_account(rq, 1);
+		edf_push(&rq->edf, proc);
+		pthread_mutex_unlock(&rq->lock);
+
+		if (proc->deadline <
+		    __atomic_load_n(&rq->curr_deadline, __ATOMIC_RELAXED))
+			__atomic_store_n(&rq->need_resched, 1, __ATOMIC_RELAXED);
+		return 0;
+	}
+	return -1;
 }
 
 void add_proc(struct pcb_t * proc) {
-	proc->krnl->ready_queue = &ready_queue;
-	proc->krnl->running_list = &running_list;
+	struct runqueue_t *rq;
+	int i, start, best, queued = 0;
+	long rank;
 
-	/* TODO: put running proc to running_list 
-	 *       It worth to protect by a mechanism.
-	 * 
+	proc->krnl->running_list = running_list;
+	proc->krnl->running_lock = running_lock;
+	proc->krnl->nr_cpus = nr_rqs;
+	proc->arrival = current_time();
+	proc->sum_exec = 0;
+	proc->vruntime = 0;
+	proc->level = 0;
+	proc->nr_io = proc->nr_io_seen = 0;
+	proc->sleep_until = 0;
+	proc->rt = 0;
+
+	if (proc->deadline && add_rt_proc(proc) == 0)
+		return;
+
+	/*
+	 * A newcomer more urgent than some running process goes to that
+	 * CPU, which is told to reschedule at its next instruction.
+	 * Otherwise place it on the least loaded CPU, ties rotate.
 	 */
+	rank = policy->rank ? policy->rank(proc) : LONG_MAX;
+	best = policy->rank ? find_preempt_target(rank) : -1;
+	if (best < 0) {
+		start = __atomic_fetch_add(&next_rq, 1, __ATOMIC_RELAXED) % nr_rqs;
+		best = start;
+		for (i = 1; i < nr_rqs; i++) {
+			int cpu = (start + i) % nr_rqs;
+			if (rq_load(&runqueue[cpu]) < rq_load(&runqueue[best]))
+				best = cpu;
+		}
+	}
+	proc->cpu = best;
+	rq = &runqueue[best];
+
+	/* [proc] may run and exit on another CPU as soon as it is queued */
+	rq_account(rq, 1);
+#ifdef QUEUE_LOCKFREE
+	/* A full inbox means a burst of arrivals: take the slow path */
+	queued = (lfq_enqueue(&rq->inbox, proc) == 0);
+#endif
+	if (!queued) {
+		pthread_mutex_lock(&rq->lock);
+		policy->add(rq->state, proc);
+		pthread_mutex_unlock(&rq->lock);
+	}
+	if (rank < __atomic_load_n(&rq->curr_rank, __ATOMIC_RELAXED))
+		__atomic_store_n(&rq->need_resched, 1, __ATOMIC_RELAXED);
+}
+
+/*
+ * Turnaround (arrival to exit) and waiting time (turnaround minus the
+ * slots spent running) of every finished process, and lateness (exit
+ * minus deadline) of the ones with a deadline, in time slots
+ */
+struct samples {
+	int64_t *v;
+	int nr, cap;
+};
+
+static struct {
+	pthread_mutex_t lock;
+	struct samples turnaround;
+	struct samples waiting;
+	struct samples lateness;
+	int nr_rt;		/* admitted to the EDF class */
+	int nr_missed;
+} stats = { .lock = PTHREAD_MUTEX_INITIALIZER };
+
+static void sample(struct samples *s, int64_t v) {
+	if (s->nr == s->cap) {
+		s->cap = s->cap ? s->cap * 2 : 64;
+		s->v = realloc(s->v, s->cap * sizeof(int64_t));
+	}
+	s->v[s->nr++] = v;
+}
+
+void finish_proc(struct pcb_t * proc) {
+	uint64_t now, turnaround;
+
+	running_del(proc);
+	account_exec(proc);
+	if (proc->rt) {
+		struct runqueue_t *rq = &runqueue[proc->cpu];
+		pthread_mutex_lock(&rq->lock);
+		edf_release(&rq->edf, proc);
+		pthread_mutex_unlock(&rq->lock);
+	}
+	now = current_time();
+	turnaround = now - proc->arrival;
+
+	pthread_mutex_lock(&stats.lock);
+	sample(&stats.turnaround, turnaround);
+	sample(&stats.waiting, turnaround - proc->sum_exec);
+	if (proc->deadline) {
+		sample(&stats.lateness, (int64_t)(now - proc->deadline));
+		stats.nr_rt += proc->rt;
+		stats.nr_missed += (now > proc->deadline);
+	}
+	pthread_mutex_unlock(&stats.lock);
+}
 
-	pthread_mutex_lock(&queue_lock);
-	enqueue(&ready_queue, proc);
-	pthread_mutex_unlock(&queue_lock);	
+static int cmp_i64(const void *a, const void *b) {
+	int64_t x = *(const int64_t *)a, y = *(const int64_t *)b;
+	return (x > y) - (x < y);
+}
+
+static void print_dist(const char *name, struct samples *s) {
+	int64_t *v = s->v, sum = 0;
+	int i, n = s->nr;
+
+	qsort(v, n, sizeof(int64_t), cmp_i64);
+	for (i = 0; i < n; i++)
+		sum += v[i];
+	printf("  [+] %-10s avg %8.2f  p50 %6ld  p95 %6ld  p99 %6ld  max %6ld\n",
+		name, (double)sum / n,
+		(long)v[n / 2], (long)v[n * 95 / 100],
+		(long)v[n * 99 / 100], (long)v[n - 1]);
+}
+
+void print_sched_stats(void) {
+	printf("\n============================================================\n");
+	printf("           SCHEDULING STATISTICS (policy: %s)\n",
+		policy->name);
+	printf("============================================================\n");
+	printf("  [+] Finished processes : %d\n", stats.turnaround.nr);
+	if (stats.turnaround.nr > 0) {
+		print_dist("Turnaround", &stats.turnaround);
+		print_dist("Waiting", &stats.waiting);
+	}
+	if (stats.lateness.nr > 0) {
+		printf("  [+] With deadline      : %d (EDF admitted %d, rejected %d)\n",
+			stats.lateness.nr, stats.nr_rt,
+			stats.lateness.nr - stats.nr_rt);
+		printf("  [+] Deadline misses    : %d\n", stats.nr_missed);
+		print_dist("Lateness", &stats.lateness);
+	}
+	printf("============================================================\n\n");
 }
-#endif
\ No newline at end of file
@@ -12,8 +12,10 @@
 #include "syscall.h"
 #include "libmem.h"
 #include "queue.h"
+#include "sched.h"
 #include <stdlib.h>
 #include <stdio.h>
+#include <pthread.h>
 
 #ifdef MM64
 #include "mm64.h"
@@ -28,32 +30,31 @@ extern int MEMPHY_read(struct memphy_struct *mp, addr_t addr, BYTE *value);
 extern int MEMPHY_write(struct memphy_struct *mp, addr_t addr, BYTE data);
 
 /* Helper: Tìm PCB an toàn */
-static struct pcb_t *find_proc_safe(struct krnl_t *krnl, uint32_t pid) {
+struct pcb_t *find_proc_safe(struct krnl_t *krnl, uint32_t pid) {
     if (!krnl) return NULL;
 
     struct queue_t *q;
-
-    /* 1. Tìm trong running_list */
-    q = krnl->running_list;
-    if (q) { /* PHẢI KIỂM TRA q KHÁC NULL TRƯỚC */
-        for (int i = 0; i < MAX_QUEUE_SIZE; i++) {
+    struct pcb_t *found = NULL;
+
+    /* 1. Tìm trong running_list của từng CPU */
+    /* Under the list's lock, its CPU may grow the slot array meanwhile */
+    for (int cpu = 0; cpu < krnl->nr_cpus && !found; cpu++) {
+        q = &krnl->running_list[cpu];
+        pthread_mutex_lock(&krnl->running_lock[cpu]);
+        for (int i = 0; i < q->cap; i++) {
             if (q->proc[i] && q->proc[i]->pid == pid) {
-                return q->proc[i];
+                found = q->proc[i];
+                break;
             }
         }
+        pthread_mutex_unlock(&krnl->running_lock[cpu]);
     }
 
-    /* 2. Tìm trong ready_queue */
-    q = krnl->ready_queue;
-    if (q) { /* PHẢI KIỂM TRA q KHÁC NULL TRƯỚC */
-        for (int i = 0; i < MAX_QUEUE_SIZE; i++) {
-            if (q->proc[i] && q->proc[i]->pid == pid) {
-                return q->proc[i];
-            }
-        }
-    }
+    /* 2. Tìm trong ready queue của từng CPU */
+    if (!found)
+        found = find_ready_proc(pid);
 
-    return NULL;
+    return found;
 }
 
 int __sys_memmap(struct krnl_t *krnl, uint32_t pid, struct sc_regs* regs)
@@ -0,0 +1,28 @@
+/*
+ * Copyright (C) 2026 pdnguyen of HCMC University of Technology VNU-HCM
+ */
+
+/* LamiaAtrium release
+ * Source Code License Grant: The authors hereby grant to Licensee
+ * personal permission to use and modify the Licensed Source Code
+ * for the sole purpose of studying while attending the course CO2018.
+ */
+
+#include "syscall.h"
+#include "timer.h"
+
+/*
+ * sleep: a1 = time slots to sleep. The CPU parks the caller once the
+ * instruction is done, and it goes back to the run queue when the
+ * clock reaches the time slot it asked for.
+ */
+int __sys_sleep(struct krnl_t *krnl, uint32_t pid, struct sc_regs *regs)
+{
+	struct pcb_t *caller = find_proc_safe(krnl, pid);
+
+	if (!caller)
+		return -1;
+	if (regs->a1 > 0)
+		caller->sleep_until = current_time() + regs->a1;
+	return 0;
+}
@@ -1,9 +1,72 @@
-
 #include "timer.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <unistd.h>
+
+/*
+ * Devices meet at a sense-reversing barrier at the end of each time
+ * slot. [barrier] packs the number of attached devices (high half)
+ * with the number arrived in the current slot (low half), so arriving
+ * and detaching are single atomic operations. The last device to
+ * arrive advances the clock, resets the count and flips [generation],
+ * which releases the others. Waiters spin a little on multiprocessors,
+ * then sleep on [generation]. A device may also sleep through several
+ * time slots without taking part in their barriers.
+ */
+#define TIMER_SPIN 256
+
+#define ATTACHED(b)	((uint32_t)((b) >> 32))
+#define ARRIVED(b)	((uint32_t)(b))
+#define ONE_DEVICE	(1ULL << 32)
+
+#if defined(__x86_64__) || defined(__i386__)
+#define cpu_relax() __builtin_ia32_pause()
+#else
+#define cpu_relax() do { } while (0)
+#endif
+
+#if defined(__linux__) && defined(__x86_64__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+
+/* libc's syscall() is shadowed by the simulated one in syscall.c */
+static void futex(unsigned int * uaddr, int op, unsigned int val) {
+	long ret;
+	register void * timeout __asm__("r10") = NULL;
+
+	__asm__ volatile ("syscall"
+		: "=a"(ret)
+		: "a"((long)SYS_futex), "D"(uaddr), "S"((long)op),
+		  "d"((long)val), "r"(timeout)
+		: "rcx", "r11", "memory");
+	(void)ret;
+}
+
+static void sleep_while(unsigned int * word, unsigned int val) {
+	while (__atomic_load_n(word, __ATOMIC_SEQ_CST) == val)
+		futex(word, FUTEX_WAIT_PRIVATE, val);
+}
 
-static pthread_t _timer;
+static void wake_all(unsigned int * word) {
+	futex(word, FUTEX_WAKE_PRIVATE, 0x7fffffff);
+}
+#else
+static pthread_mutex_t sleep_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t sleep_cond = PTHREAD_COND_INITIALIZER;
+
+static void sleep_while(unsigned int * word, unsigned int val) {
+	pthread_mutex_lock(&sleep_lock);
+	while (__atomic_load_n(word, __ATOMIC_SEQ_CST) == val)
+		pthread_cond_wait(&sleep_cond, &sleep_lock);
+	pthread_mutex_unlock(&sleep_lock);
+}
+
+static void wake_all(unsigned int * word) {
+	pthread_mutex_lock(&sleep_lock);
+	pthread_cond_broadcast(&sleep_cond);
+	pthread_mutex_unlock(&sleep_lock);
+}
+#endif
 
 struct timer_id_container_t {
 	struct timer_id_t id;
@@ -15,81 +78,141 @@ static struct timer_id_container_t * dev_list = NULL;
 static uint64_t _time;
 
 static int timer_started = 0;
-static int timer_stop = 0;
-
-
-static void * timer_routine(void * args) {
-	while (!timer_stop) {
-		printf("Time slot %3llu\n", (unsigned long long)current_time());
-		int fsh = 0;
-		int event = 0;
-		/* Wait for all devices have done the job in current
-		 * time slot */
-		struct timer_id_container_t * temp;
-		for (temp = dev_list; temp != NULL; temp = temp->next) {
-			pthread_mutex_lock(&temp->id.event_lock);
-			while (!temp->id.done && !temp->id.fsh) {
-				pthread_cond_wait(
-					&temp->id.event_cond,
-					&temp->id.event_lock
-				);
-			}
-			if (temp->id.fsh) {
-				fsh++;
-			}
-			event++;
-			pthread_mutex_unlock(&temp->id.event_lock);
-		}
 
-		/* Increase the time slot */
-		_time++;
-		
-		/* Let devices continue their job */
-		for (temp = dev_list; temp != NULL; temp = temp->next) {
-			pthread_mutex_lock(&temp->id.timer_lock);
-			temp->id.done = 0;
-			pthread_cond_signal(&temp->id.timer_cond);
-			pthread_mutex_unlock(&temp->id.timer_lock);
+static uint64_t barrier;
+static unsigned int generation;
+/* Time slot the last barrier released the devices into. Sleepers test
+ * it rather than _time, which runs ahead while a slot completes */
+static uint64_t released;
+
+static int nr_sleepers;
+static int spin_limit;
+
+/* Timed events, fired by the device completing a time slot */
+static struct timing_wheel wheel;
+static pthread_mutex_t wheel_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/*
+ * Called by the device completing the slot, every other one waits.
+ * The clock runs to the earliest time slot some device has work in or
+ * an event is due, logging the slots in between and firing the events
+ * on the way. Devices sleeping past it stay counted as arrived for the
+ * next slot.
+ */
+static void complete_slot(uint64_t b) {
+	struct timer_id_container_t * dev;
+	uint64_t next;
+	uint32_t asleep;
+
+	do {
+		next = wheel_next(&wheel);
+		for (dev = dev_list; dev != NULL; dev = dev->next)
+			if (!dev->id.fsh && dev->id.wake < next)
+				next = dev->id.wake;
+		if (next == TIMER_NEVER || next <= _time)
+			next = _time + 1;
+		asleep = 0;
+		for (dev = dev_list; dev != NULL; dev = dev->next)
+			if (!dev->id.fsh && !dev->id.idle &&
+			    dev->id.wake > next)
+				asleep++;
+
+		while (_time < next) {
+			__atomic_store_n(&_time, _time + 1, __ATOMIC_RELAXED);
+			if (ATTACHED(b) > 0)
+				printf("Time slot %3llu\n",
+					(unsigned long long)current_time());
+			wheel_advance(&wheel, _time);
 		}
-		if (fsh == event) {
+		/* Stopped for an event only, all devices still asleep */
+	} while (ATTACHED(b) > 0 && asleep == ATTACHED(b));
+
+	__atomic_store_n(&barrier, (b & ~0xffffffffULL) | asleep,
+			__ATOMIC_RELAXED);
+	__atomic_store_n(&released, _time, __ATOMIC_RELEASE);
+	__atomic_add_fetch(&generation, 1, __ATOMIC_SEQ_CST);
+	if (__atomic_load_n(&nr_sleepers, __ATOMIC_SEQ_CST) > 0)
+		wake_all(&generation);
+}
+
+static void wait_slot(unsigned int gen) {
+	int i;
+
+	for (i = 0; i < spin_limit; i++) {
+		if (__atomic_load_n(&generation, __ATOMIC_ACQUIRE) != gen)
+			return;
+		cpu_relax();
+	}
+
+	__atomic_add_fetch(&nr_sleepers, 1, __ATOMIC_SEQ_CST);
+	sleep_while(&generation, gen);
+	__atomic_sub_fetch(&nr_sleepers, 1, __ATOMIC_RELAXED);
+}
+
+static void arrive(struct timer_id_t * timer_id, uint64_t wake, int idle) {
+	/* The slot cannot end before we arrive, so gen is still current */
+	unsigned int gen = __atomic_load_n(&generation, __ATOMIC_ACQUIRE);
+	uint64_t b;
+
+	timer_id->wake = wake;
+	timer_id->idle = idle;
+	b = __atomic_add_fetch(&barrier, 1, __ATOMIC_ACQ_REL);
+	if (ARRIVED(b) == ATTACHED(b))
+		complete_slot(b);
+	else
+		wait_slot(gen);
+
+	/*
+	 * Asleep past the slot that just ended. A sleeper counts as arrived
+	 * until the barrier releasing its wake slot is set up, so it must
+	 * not arrive again before that, even if _time has got there.
+	 */
+	while (!idle) {
+		gen = __atomic_load_n(&generation, __ATOMIC_ACQUIRE);
+		if (__atomic_load_n(&released, __ATOMIC_ACQUIRE) >= wake)
 			break;
-		}
+		wait_slot(gen);
 	}
-	pthread_exit(args);
+}
+
+void next_slot_at(struct timer_id_t * timer_id, uint64_t wake) {
+	arrive(timer_id, wake, wake == TIMER_NEVER);
+}
+
+void next_slot_idle(struct timer_id_t * timer_id, uint64_t wake) {
+	arrive(timer_id, wake, 1);
 }
 
 void next_slot(struct timer_id_t * timer_id) {
-	/* Tell to timer that we have done our job in current slot */
-	pthread_mutex_lock(&timer_id->event_lock);
-	timer_id->done = 1;
-	pthread_cond_signal(&timer_id->event_cond);
-	pthread_mutex_unlock(&timer_id->event_lock);
-
-	/* Wait for going to next slot */
-	pthread_mutex_lock(&timer_id->timer_lock);
-	while (timer_id->done) {
-		pthread_cond_wait(
-			&timer_id->timer_cond,
-			&timer_id->timer_lock
-		);
-	}
-	pthread_mutex_unlock(&timer_id->timer_lock);
+	arrive(timer_id, current_time() + 1, 0);
 }
 
 uint64_t current_time() {
-	return _time;
+	return __atomic_load_n(&_time, __ATOMIC_RELAXED);
 }
 
 void start_timer() {
 	timer_started = 1;
-	pthread_create(&_timer, NULL, timer_routine, NULL);
+	/* Spinning only delays the last arriver on a uniprocessor */
+	spin_limit = sysconf(_SC_NPROCESSORS_ONLN) > 1 ? TIMER_SPIN : 0;
+	printf("Time slot %3llu\n", (unsigned long long)current_time());
+	wheel_advance(&wheel, _time);
+}
+
+void timer_add(struct wheel_timer * event) {
+	pthread_mutex_lock(&wheel_lock);
+	wheel_add(&wheel, event);
+	pthread_mutex_unlock(&wheel_lock);
 }
 
 void detach_event(struct timer_id_t * event) {
-	pthread_mutex_lock(&event->event_lock);
+	uint64_t b;
+
 	event->fsh = 1;
-	pthread_cond_signal(&event->event_cond);
-	pthread_mutex_unlock(&event->event_lock);
+	b = __atomic_sub_fetch(&barrier, ONE_DEVICE, __ATOMIC_ACQ_REL);
+	/* The others may all be waiting on us already */
+	if (ARRIVED(b) > 0 && ARRIVED(b) == ATTACHED(b))
+		complete_slot(b);
 }
 
 struct timer_id_t * attach_event() {
@@ -100,12 +223,10 @@ struct timer_id_t * attach_event() {
 			(struct timer_id_container_t*)malloc(
 				sizeof(struct timer_id_container_t)		
 			);
-		container->id.done = 0;
 		container->id.fsh = 0;
-		pthread_cond_init(&container->id.event_cond, NULL);
-		pthread_mutex_init(&container->id.event_lock, NULL);
-		pthread_cond_init(&container->id.timer_cond, NULL);
-		pthread_mutex_init(&container->id.timer_lock, NULL);
+		container->id.wake = 0;
+		container->id.idle = 0;
+		__atomic_add_fetch(&barrier, ONE_DEVICE, __ATOMIC_RELAXED);
 		if (dev_list == NULL) {
 			dev_list = container;
 			dev_list->next = NULL;
@@ -118,19 +239,9 @@ struct timer_id_t * attach_event() {
 }
 
 void stop_timer() {
-	timer_stop = 1;
-	pthread_join(_timer, NULL);
 	while (dev_list != NULL) {
 		struct timer_id_container_t * temp = dev_list;
 		dev_list = dev_list->next;
-		pthread_cond_destroy(&temp->id.event_cond);
-		pthread_mutex_destroy(&temp->id.event_lock);
-		pthread_cond_destroy(&temp->id.timer_cond);
-		pthread_mutex_destroy(&temp->id.timer_lock);
 		free(temp);
 	}
 }
-
-
-
-
@@ -0,0 +1,132 @@
+/*
+ * Hierarchical timing wheel. A timer [delta] time slots away goes to
+ * level l when delta < WHEEL_SIZE^(l+1), in the slot picked by bits
+ * [l * WHEEL_BITS, (l+1) * WHEEL_BITS) of its expiry. When the clock
+ * crosses a multiple of WHEEL_SIZE^l, the level l slot it enters is
+ * emptied into the levels below; level 0 slots fire.
+ */
+
+#include "wheel.h"
+
+#define LEVEL_SHIFT(l)	((l) * WHEEL_BITS)
+/* Farthest a timer can be, later ones are parked on the top level */
+#define WHEEL_SPAN	((1ULL << LEVEL_SHIFT(WHEEL_LEVELS)) - 1)
+
+static void link_timer(struct timing_wheel *wheel, int level, int idx,
+		       struct wheel_timer *timer) {
+	struct wheel_timer **head = &wheel->slot[level][idx];
+
+	timer->next = *head;
+	if (*head)
+		(*head)->pprev = &timer->next;
+	timer->pprev = head;
+	*head = timer;
+	wheel->pending[level] |= 1ULL << idx;
+}
+
+void wheel_add(struct timing_wheel *wheel, struct wheel_timer *timer) {
+	uint64_t expires = timer->expires;
+	uint64_t delta;
+	int level;
+
+	/* Already due: fire in the next time slot processed */
+	if (expires < wheel->now)
+		expires = wheel->now;
+	delta = expires - wheel->now;
+	if (delta > WHEEL_SPAN)
+		expires = wheel->now + WHEEL_SPAN;
+
+	for (level = 0; level < WHEEL_LEVELS - 1; level++)
+		if (delta < (1ULL << LEVEL_SHIFT(level + 1)))
+			break;
+	link_timer(wheel, level,
+		   (expires >> LEVEL_SHIFT(level)) & WHEEL_MASK, timer);
+}
+
+void wheel_del(struct timing_wheel *wheel, struct wheel_timer *timer) {
+	struct wheel_timer **first = &wheel->slot[0][0];
+	struct wheel_timer **pprev = timer->pprev;
+
+	if (pprev == NULL)
+		return;
+	*pprev = timer->next;
+	if (timer->next)
+		timer->next->pprev = pprev;
+	timer->pprev = NULL;
+
+	/* It was alone in its slot: pprev is the slot head */
+	if (*pprev == NULL && pprev >= first &&
+	    pprev < first + WHEEL_LEVELS * WHEEL_SIZE) {
+		long off = pprev - first;
+		wheel->pending[off / WHEEL_SIZE] &= ~(1ULL << (off & WHEEL_MASK));
+	}
+}
+
+/* Unlink every timer of a slot, the list is returned */
+static struct wheel_timer *take_slot(struct timing_wheel *wheel, int level,
+				     int idx) {
+	struct wheel_timer *list = wheel->slot[level][idx];
+
+	wheel->slot[level][idx] = NULL;
+	wheel->pending[level] &= ~(1ULL << idx);
+	return list;
+}
+
+/* Move the timers of the level [level] slot the clock enters down */
+static void cascade(struct timing_wheel *wheel, int level) {
+	int idx = (wheel->now >> LEVEL_SHIFT(level)) & WHEEL_MASK;
+	struct wheel_timer *timer = take_slot(wheel, level, idx);
+
+	while (timer) {
+		struct wheel_timer *next = timer->next;
+		wheel_add(wheel, timer);
+		timer = next;
+	}
+}
+
+void wheel_advance(struct timing_wheel *wheel, uint64_t now) {
+	struct wheel_timer *timer;
+	int level;
+
+	while (wheel->now <= now) {
+		/* Crossing a multiple of WHEEL_SIZE^level */
+		for (level = 1; level < WHEEL_LEVELS; level++) {
+			if (wheel->now & ((1ULL << LEVEL_SHIFT(level)) - 1))
+				break;
+			cascade(wheel, level);
+		}
+
+		timer = take_slot(wheel, 0, wheel->now & WHEEL_MASK);
+		wheel->now++;
+		while (timer) {
+			struct wheel_timer *next = timer->next;
+			/* The callback may add it again */
+			timer->pprev = NULL;
+			timer->fn(timer);
+			timer = next;
+		}
+	}
+}
+
+uint64_t wheel_next(struct timing_wheel *wheel) {
+	uint64_t next = UINT64_MAX;
+	int level;
+
+	for (level = 0; level < WHEEL_LEVELS; level++) {
+		int shift = LEVEL_SHIFT(level);
+		/* First time slot the level visits a slot from now on */
+		uint64_t from = (wheel->now + (1ULL << shift) - 1) >> shift;
+		uint64_t bits = wheel->pending[level];
+		uint64_t at;
+
+		if (bits == 0)
+			continue;
+		/* Rotate so bit 0 stands for the slot of [from] */
+		bits = (bits >> (from & WHEEL_MASK)) |
+		       (bits << ((WHEEL_SIZE - (from & WHEEL_MASK)) & WHEEL_MASK));
+		at = (from + __builtin_ctzll(bits)) << shift;
+		if (at < next)
+			next = at;
+	}
+	return next;
+}
@@ -0,0 +1,69 @@
+/*
+ * procc: compile a text program (input/proc/...) into a binary process
+ * image the loader maps instead of parsing, see struct proc_image_hdr.
+ *
+ *	procc <program> <image>
+ *
+ * The image holds the program decoded and fused the way this build's
+ * loader does it, so rebuild the images along with the os binary.
+ */
+
+#include "loader.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Offsets of the sections are aligned to this */
+#define IMAGE_ALIGN 16
+
+static uint64_t align(uint64_t off) {
+	return (off + IMAGE_ALIGN - 1) & ~(uint64_t)(IMAGE_ALIGN - 1);
+}
+
+/* Write [len] bytes of [buf] at [off], zero filling up to it */
+static void put(FILE * file, uint64_t off, const void * buf, size_t len) {
+	while ((uint64_t)ftell(file) < off)
+		fputc(0, file);
+	if (len > 0 && fwrite(buf, len, 1, file) != 1) {
+		perror("procc");
+		exit(1);
+	}
+}
+
+int main(int argc, char * argv[]) {
+	struct proc_image_hdr hdr;
+	struct code_seg_t code;
+	uint32_t priority;
+	FILE * file;
+
+	if (argc != 3) {
+		fprintf(stderr, "usage: %s <program> <image>\n", argv[0]);
+		return 1;
+	}
+	load_code(argv[1], &code, &priority);
+
+	memset(&hdr, 0, sizeof(hdr));
+	memcpy(hdr.magic, PROC_IMAGE_MAGIC, sizeof(hdr.magic));
+	hdr.version = PROC_IMAGE_VERSION;
+	hdr.op_size = sizeof(struct op_t);
+	hdr.priority = priority;
+	hdr.size = code.size;
+	hdr.nr_wide = code.nr_wide;
+	hdr.text = align(sizeof(hdr));
+	hdr.wide = align(hdr.text + (uint64_t)code.size * sizeof(struct op_t));
+
+	if ((file = fopen(argv[2], "wb")) == NULL) {
+		perror(argv[2]);
+		return 1;
+	}
+	put(file, 0, &hdr, sizeof(hdr));
+	put(file, hdr.text, code.text, code.size * sizeof(struct op_t));
+	put(file, hdr.wide, code.wide, code.nr_wide * sizeof(arg_t));
+	if (fclose(file) != 0) {
+		perror(argv[2]);
+		return 1;
+	}
+	printf("%s: %u instructions, %u wide operands\n",
+		argv[2], code.size, code.nr_wide);
+	return 0;
+}
@@ -0,0 +1,256 @@
+/*
+ * wlgen: synthetic workload generator. Writes the config input/gen/<name>
+ * and its programs input/proc/gen/<name>/p<k>, run with "os gen/<name>".
+ * Run it from the top of the tree.
+ *
+ *	wlgen [options] <name>
+ *
+ *	-c cpus		CPUs (4)
+ *	-t slot		time slot (4)
+ *	-p procs	processes (16)
+ *	-d progs	distinct programs, processes share them round robin
+ *			(procs)
+ *	-n insns	instructions per program (1000)
+ *	-m mix		weights of calc,alloc,free,read,write,sleep
+ *			(60,5,3,15,15,2)
+ *	-a min:max	allocation sizes in bytes (64:1024)
+ *	-w regions	working set: most regions alive at once, 1 to 10 (4)
+ *	-l percent	locality: accesses next to the previous one (80)
+ *	-r rate		arrivals per time slot, Poisson (1)
+ *	-R bytes	MEMRAM size (1048576)
+ *	-S bytes	MEMSWP0 size (16777216)
+ *	-s seed		(1)
+ *
+ * Every READ and WRITE hits a live region, so any mix runs clean.
+ */
+
+#include <errno.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define NR_REGS 10	/* registers of a process, see pcb_t.regs */
+
+enum { MIX_CALC, MIX_ALLOC, MIX_FREE, MIX_READ, MIX_WRITE, MIX_SLEEP,
+	NR_MIX };
+
+static struct {
+	int cpus, time_slot, procs, progs, insns;
+	int mix[NR_MIX], mix_total;
+	unsigned long alloc_min, alloc_max;
+	int regions, locality;
+	double rate;
+	unsigned long ram, swap;
+	uint64_t seed;
+} opt = {
+	.cpus = 4, .time_slot = 4, .procs = 16, .progs = 0, .insns = 1000,
+	.mix = { 60, 5, 3, 15, 15, 2 },
+	.alloc_min = 64, .alloc_max = 1024,
+	.regions = 4, .locality = 80, .rate = 1.0,
+	.ram = 1048576, .swap = 16777216, .seed = 1,
+};
+
+/* xorshift64*, the same stream on every host */
+static uint64_t rng_state;
+
+static uint64_t rng(void) {
+	rng_state ^= rng_state >> 12;
+	rng_state ^= rng_state << 25;
+	rng_state ^= rng_state >> 27;
+	return rng_state * 0x2545F4914F6CDD1DULL;
+}
+
+static unsigned long uniform(unsigned long lo, unsigned long hi) {
+	return lo + rng() % (hi - lo + 1);
+}
+
+static void mkdirs(const char * path) {
+	char buf[512];
+	char * p;
+
+	snprintf(buf, sizeof(buf), "%s", path);
+	for (p = buf + 1; *p; p++) {
+		if (*p != '/')
+			continue;
+		*p = '\0';
+		if (mkdir(buf, 0755) < 0 && errno != EEXIST) {
+			perror(buf);
+			exit(1);
+		}
+		*p = '/';
+	}
+	if (mkdir(buf, 0755) < 0 && errno != EEXIST) {
+		perror(buf);
+		exit(1);
+	}
+}
+
+/* Live regions of the program being written */
+static struct {
+	unsigned long size[NR_REGS];	/* 0 when the register is free */
+	unsigned long last[NR_REGS];	/* offset of the last access */
+	int live;
+} ws;
+
+static int pick_reg(int live) {
+	int r;
+
+	do
+		r = rng() % NR_REGS;
+	while ((ws.size[r] != 0) != live);
+	return r;
+}
+
+/* Offset of the next access to region [r] */
+static unsigned long pick_offset(int r) {
+	unsigned long off = ws.last[r];
+
+	if ((int)(rng() % 100) < opt.locality)
+		off = (off + 1) % ws.size[r];
+	else
+		off = rng() % ws.size[r];
+	ws.last[r] = off;
+	return off;
+}
+
+static void gen_program(const char * path) {
+	FILE * file;
+	int i, kind, r;
+	long w;
+
+	if ((file = fopen(path, "w")) == NULL) {
+		perror(path);
+		exit(1);
+	}
+	memset(&ws, 0, sizeof(ws));
+	fprintf(file, "0 %d\n", opt.insns);
+	for (i = 0; i < opt.insns; i++) {
+		w = rng() % opt.mix_total;
+		for (kind = 0; w >= opt.mix[kind]; kind++)
+			w -= opt.mix[kind];
+
+		/* Keep the working set within bounds and accesses valid */
+		if (kind == MIX_ALLOC && ws.live == opt.regions)
+			kind = MIX_FREE;
+		if (kind != MIX_CALC && kind != MIX_SLEEP && ws.live == 0)
+			kind = MIX_ALLOC;
+
+		switch (kind) {
+		case MIX_CALC:
+			fprintf(file, "calc\n");
+			break;
+		case MIX_ALLOC:
+			r = pick_reg(0);
+			ws.size[r] = uniform(opt.alloc_min, opt.alloc_max);
+			ws.last[r] = 0;
+			ws.live++;
+			fprintf(file, "alloc %lu %d\n", ws.size[r], r);
+			break;
+		case MIX_FREE:
+			r = pick_reg(1);
+			ws.size[r] = 0;
+			ws.live--;
+			fprintf(file, "free %d\n", r);
+			break;
+		case MIX_READ:
+			r = pick_reg(1);
+			fprintf(file, "read %d %lu %d\n", r, pick_offset(r),
+				(int)(rng() % NR_REGS));
+			break;
+		case MIX_WRITE:
+			r = pick_reg(1);
+			fprintf(file, "write %d %d %lu\n", (int)(rng() % 256), r,
+				pick_offset(r));
+			break;
+		case MIX_SLEEP:
+			fprintf(file, "syscall 18 %d\n", (int)uniform(1, 4));
+			break;
+		}
+	}
+	fclose(file);
+}
+
+static void usage(const char * prog) {
+	fprintf(stderr, "usage: %s [-c cpus] [-t slot] [-p procs] [-d progs] "
+		"[-n insns]\n\t[-m calc,alloc,free,read,write,sleep] "
+		"[-a min:max] [-w regions]\n\t[-l locality%%] [-r rate] "
+		"[-R ram] [-S swap] [-s seed] <name>\n", prog);
+	exit(1);
+}
+
+int main(int argc, char * argv[]) {
+	char path[512];
+	FILE * file;
+	double t = 0;
+	int c, i;
+
+	while ((c = getopt(argc, argv, "c:t:p:d:n:m:a:w:l:r:R:S:s:")) != -1) {
+		switch (c) {
+		case 'c': opt.cpus = atoi(optarg); break;
+		case 't': opt.time_slot = atoi(optarg); break;
+		case 'p': opt.procs = atoi(optarg); break;
+		case 'd': opt.progs = atoi(optarg); break;
+		case 'n': opt.insns = atoi(optarg); break;
+		case 'm':
+			if (sscanf(optarg, "%d,%d,%d,%d,%d,%d", &opt.mix[0],
+					&opt.mix[1], &opt.mix[2], &opt.mix[3],
+					&opt.mix[4], &opt.mix[5]) != NR_MIX)
+				usage(argv[0]);
+			break;
+		case 'a':
+			if (sscanf(optarg, "%lu:%lu", &opt.alloc_min,
+					&opt.alloc_max) != 2)
+				usage(argv[0]);
+			break;
+		case 'w': opt.regions = atoi(optarg); break;
+		case 'l': opt.locality = atoi(optarg); break;
+		case 'r': opt.rate = atof(optarg); break;
+		case 'R': opt.ram = strtoul(optarg, NULL, 0); break;
+		case 'S': opt.swap = strtoul(optarg, NULL, 0); break;
+		case 's': opt.seed = strtoull(optarg, NULL, 0); break;
+		default: usage(argv[0]);
+		}
+	}
+	if (optind != argc - 1)
+		usage(argv[0]);
+	if (opt.progs <= 0 || opt.progs > opt.procs)
+		opt.progs = opt.procs;
+	for (i = 0, opt.mix_total = 0; i < NR_MIX; i++)
+		opt.mix_total += opt.mix[i];
+	if (opt.cpus < 1 || opt.procs < 1 || opt.insns < 1 ||
+	    opt.mix_total <= 0 || opt.regions < 1 || opt.regions > NR_REGS ||
+	    opt.alloc_min < 1 || opt.alloc_min > opt.alloc_max ||
+	    opt.rate <= 0)
+		usage(argv[0]);
+	rng_state = opt.seed * 0x9E3779B97F4A7C15ULL + 1;
+
+	snprintf(path, sizeof(path), "input/proc/gen/%s", argv[optind]);
+	mkdirs(path);
+	for (i = 0; i < opt.progs; i++) {
+		snprintf(path, sizeof(path), "input/proc/gen/%s/p%d",
+			argv[optind], i);
+		gen_program(path);
+	}
+
+	mkdirs("input/gen");
+	snprintf(path, sizeof(path), "input/gen/%s", argv[optind]);
+	if ((file = fopen(path, "w")) == NULL) {
+		perror(path);
+		return 1;
+	}
+	fprintf(file, "%d %d %d\n", opt.time_slot, opt.cpus, opt.procs);
+	fprintf(file, "%lu %lu 0 0 0\n", opt.ram, opt.swap);
+	for (i = 0; i < opt.procs; i++) {
+		/* Exponential gaps between arrivals */
+		fprintf(file, "%lu gen/%s/p%d %lu\n", (unsigned long)t,
+			argv[optind], i % opt.progs, uniform(0, 139));
+		t += -log(1.0 - (rng() >> 11) * (1.0 / 9007199254740992.0)) /
+			opt.rate;
+	}
+	fclose(file);
+	return 0;
+}